@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "asm_template.hpp"
+
+namespace ib {
+
+namespace {
+
+using Node = AsmTemplate::Node;
+
+std::optional<int64_t> parse_int(std::string_view str) {
+  int64_t value = 0;
+  auto const [ptr, ec] =
+      std::from_chars(str.data(), str.data() + str.size(), value);
+  if (ec != std::errc{} || ptr != str.data() + str.size())
+    return std::nullopt;
+  return value;
+}
+
+// "x0-x7" => x0 .. x7
+bool expand_register_range(std::string_view item,
+                           std::vector<std::string> &values) {
+  size_t const dash = item.find('-');
+  if (dash == std::string_view::npos || dash == 0U)
+    return false;
+  std::string_view const first = item.substr(0, dash);
+  std::string_view const last = item.substr(dash + 1);
+  size_t const prefix_size = first.find_first_of("0123456789");
+  if (prefix_size == std::string_view::npos ||
+      last.substr(0, prefix_size) != first.substr(0, prefix_size))
+    return false;
+  std::optional<int64_t> const begin = parse_int(first.substr(prefix_size));
+  std::optional<int64_t> const end = parse_int(last.substr(prefix_size));
+  if (!begin.has_value() || !end.has_value() || *begin > *end)
+    return false;
+  for (int64_t i = *begin; i <= *end; i++)
+    values.push_back(std::string{first.substr(0, prefix_size)} +
+                     std::to_string(i));
+  return true;
+}
+
+// "0..64:8" => 0, 8, .. 64
+bool expand_numeric_range(std::string_view item,
+                          std::vector<std::string> &values) {
+  size_t const dots = item.find("..");
+  if (dots == std::string_view::npos)
+    return false;
+  std::string_view rest = item.substr(dots + 2);
+  int64_t step = 1;
+  if (size_t const colon = rest.find(':'); colon != std::string_view::npos) {
+    std::optional<int64_t> const parsed = parse_int(rest.substr(colon + 1));
+    if (!parsed.has_value() || *parsed <= 0)
+      return false;
+    step = *parsed;
+    rest = rest.substr(0, colon);
+  }
+  std::optional<int64_t> const begin = parse_int(item.substr(0, dots));
+  std::optional<int64_t> const end = parse_int(rest);
+  if (!begin.has_value() || !end.has_value() || *begin > *end)
+    return false;
+  for (int64_t i = *begin; i <= *end; i += step)
+    values.push_back(std::to_string(i));
+  return true;
+}
+
+std::optional<std::vector<std::string>> parse_values(std::string_view kind,
+                                                     std::string_view spec) {
+  std::vector<std::string> values{};
+  while (!spec.empty()) {
+    size_t const bar = spec.find('|');
+    std::string_view const item = spec.substr(0, bar);
+    spec = bar == std::string_view::npos ? std::string_view{}
+                                         : spec.substr(bar + 1);
+    if (kind == "reg" && expand_register_range(item, values))
+      continue;
+    if ((kind == "imm" || kind == "repeat") &&
+        expand_numeric_range(item, values))
+      continue;
+    if (kind == "repeat" && !parse_int(item).has_value())
+      return std::nullopt;
+    values.emplace_back(item);
+  }
+  if (values.empty())
+    return std::nullopt;
+  return values;
+}
+
+// "name}" or "name:" at pos, anything else is literal text like {v0.16b}
+bool is_placeholder(std::string_view source, size_t pos) {
+  auto const is_name_char = [](char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_';
+  };
+  size_t end = pos;
+  while (end < source.size() && is_name_char(source[end]))
+    end++;
+  return end > pos && end < source.size() &&
+         (source[end] == '}' || source[end] == ':');
+}
+
+class Parser {
+  std::string_view source_;
+  size_t pos_ = 0U;
+  std::vector<TemplateAxis> &axes_;
+
+  bool define_axis(std::string_view name, std::string_view kind,
+                   std::string_view spec) {
+    for (TemplateAxis const &axis : axes_) {
+      if (axis.name_ == name) {
+        spdlog::error("[template] axis {} defined twice", name);
+        return false;
+      }
+    }
+    if (kind != "reg" && kind != "imm" && kind != "list" && kind != "repeat") {
+      spdlog::error("[template] unknown kind {} of axis {}", kind, name);
+      return false;
+    }
+    std::optional<std::vector<std::string>> values = parse_values(kind, spec);
+    if (!values.has_value()) {
+      spdlog::error("[template] invalid values {} of axis {}", spec, name);
+      return false;
+    }
+    axes_.push_back({.name_ = std::string{name}, .values_ = *values});
+    return true;
+  }
+
+public:
+  Parser(std::string_view source, std::vector<TemplateAxis> &axes)
+      : source_(source), axes_(axes) {}
+
+  // parse until end or closing bracket of a repeat body
+  std::optional<std::vector<Node>> parse(bool in_repeat) {
+    std::vector<Node> nodes{};
+    std::string text{};
+    auto const flush_text = [&]() {
+      if (!text.empty())
+        nodes.push_back(
+            {.kind_ = Node::Kind::Text, .text_ = text, .body_ = {}});
+      text.clear();
+    };
+    // brackets of addressing modes inside a repeat body
+    size_t depth = 0U;
+    while (pos_ < source_.size()) {
+      char const c = source_[pos_];
+      if (c == ']' && in_repeat && depth == 0U) {
+        pos_++;
+        flush_text();
+        return nodes;
+      }
+      if (c == '{' && pos_ + 1U < source_.size() &&
+          source_[pos_ + 1U] == '{') {
+        text += c;
+        pos_ += 2U;
+        continue;
+      }
+      if (c != '{' || !is_placeholder(source_, pos_ + 1U)) {
+        if (in_repeat && c == '[')
+          depth++;
+        else if (in_repeat && c == ']')
+          depth--;
+        text += c;
+        pos_++;
+        continue;
+      }
+      size_t const close = source_.find('}', pos_);
+      if (close == std::string_view::npos) {
+        spdlog::error("[template] unclosed placeholder at {}", pos_);
+        return std::nullopt;
+      }
+      std::string_view const placeholder =
+          source_.substr(pos_ + 1, close - pos_ - 1);
+      pos_ = close + 1;
+      flush_text();
+      size_t const first_colon = placeholder.find(':');
+      std::string_view const name = placeholder.substr(0, first_colon);
+      std::string_view kind{};
+      if (first_colon != std::string_view::npos) {
+        std::string_view const rest = placeholder.substr(first_colon + 1);
+        size_t const second_colon = rest.find(':');
+        kind = rest.substr(0, second_colon);
+        std::string_view const spec = second_colon == std::string_view::npos
+                                          ? std::string_view{}
+                                          : rest.substr(second_colon + 1);
+        if (!define_axis(name, kind, spec))
+          return std::nullopt;
+      }
+      if (kind != "repeat") {
+        nodes.push_back({.kind_ = Node::Kind::Param,
+                         .text_ = std::string{name},
+                         .body_ = {}});
+        continue;
+      }
+      if (pos_ >= source_.size() || source_[pos_] != '[') {
+        spdlog::error("[template] repeat {} without [body]", name);
+        return std::nullopt;
+      }
+      pos_++;
+      std::optional<std::vector<Node>> body = parse(true);
+      if (!body.has_value())
+        return std::nullopt;
+      nodes.push_back({.kind_ = Node::Kind::Repeat,
+                       .text_ = std::string{name},
+                       .body_ = std::move(body.value())});
+    }
+    if (in_repeat) {
+      spdlog::error("[template] unclosed repeat body");
+      return std::nullopt;
+    }
+    flush_text();
+    return nodes;
+  }
+};
+
+void render(std::vector<Node> const &nodes,
+            std::map<std::string, std::string> const &assignment,
+            std::string &out) {
+  for (Node const &node : nodes) {
+    switch (node.kind_) {
+    case Node::Kind::Text:
+      out += node.text_;
+      break;
+    case Node::Kind::Param:
+      out += assignment.at(node.text_);
+      break;
+    case Node::Kind::Repeat: {
+      int64_t const count = parse_int(assignment.at(node.text_)).value_or(0);
+      // one line body would run into the next copy otherwise
+      for (int64_t i = 0; i < count; i++) {
+        render(node.body_, assignment, out);
+        if (!out.empty() && out.back() != '\n')
+          out += '\n';
+      }
+      break;
+    }
+    }
+  }
+}
+
+bool check_references(std::vector<Node> const &nodes,
+                      std::vector<TemplateAxis> const &axes) {
+  for (Node const &node : nodes) {
+    if (node.kind_ == Node::Kind::Text)
+      continue;
+    bool const defined =
+        std::any_of(axes.begin(), axes.end(), [&](TemplateAxis const &axis) {
+          return axis.name_ == node.text_;
+        });
+    if (!defined) {
+      spdlog::error("[template] undefined axis {}", node.text_);
+      return false;
+    }
+    if (!check_references(node.body_, axes))
+      return false;
+  }
+  return true;
+}
+
+} // namespace
+
+std::optional<AsmTemplate> AsmTemplate::parse(std::string const &source) {
+  std::vector<TemplateAxis> axes{};
+  Parser parser{source, axes};
+  std::optional<std::vector<Node>> nodes = parser.parse(false);
+  if (!nodes.has_value() || !check_references(nodes.value(), axes))
+    return std::nullopt;
+  return AsmTemplate{std::move(nodes.value()), std::move(axes)};
+}
+
+size_t AsmTemplate::case_count() const {
+  size_t count = 1U;
+  for (TemplateAxis const &axis : axes_)
+    count *= axis.values_.size();
+  return count;
+}
+
+std::vector<TemplateCase> AsmTemplate::expand() const {
+  std::vector<TemplateCase> cases{};
+  cases.reserve(case_count());
+  // odometer over axes, last axis changes fastest
+  std::vector<size_t> indexes(axes_.size(), 0U);
+  while (true) {
+    TemplateCase template_case{};
+    std::map<std::string, std::string> assignment{};
+    for (size_t i = 0; i < axes_.size(); i++) {
+      std::string const &value = axes_[i].values_[indexes[i]];
+      assignment[axes_[i].name_] = value;
+      template_case.params_.emplace_back(axes_[i].name_, value);
+    }
+    render(nodes_, assignment, template_case.asm_);
+    cases.push_back(std::move(template_case));
+    size_t axis = axes_.size();
+    while (axis > 0U) {
+      axis--;
+      if (++indexes[axis] < axes_[axis].values_.size())
+        break;
+      indexes[axis] = 0U;
+      if (axis == 0U)
+        return cases;
+    }
+    if (axes_.empty())
+      return cases;
+  }
+}
+
+} // namespace ib
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ib {
+
+// snippet template with placeholders, every combination becomes one case
+//   {name:reg:x0-x7}        register class, ranges and lists, x0-x3|x9
+//   {name:imm:0..64:8}      immediate range with optional step, or 1|2|4
+//   {name:list:lsl|lsr}     literal alternatives
+//   {name:repeat:1|2|4}[..] repeat bracketed body, nested [] stay in body,
+//                           each copy ends with a newline
+//   {name}                  reuse value of an axis defined elsewhere
+//   {{                      literal {, other braces not followed by a name
+//                           and } or : are literal too, e.g. {v0.16b}
+struct TemplateCase {
+  std::vector<std::pair<std::string, std::string>> params_;
+  std::string asm_;
+};
+
+struct TemplateAxis {
+  std::string name_;
+  std::vector<std::string> values_;
+};
+
+class AsmTemplate {
+public:
+  struct Node {
+    enum class Kind { Text, Param, Repeat };
+    Kind kind_;
+    std::string text_;
+    std::vector<Node> body_;
+  };
+
+private:
+  std::vector<Node> nodes_;
+  std::vector<TemplateAxis> axes_;
+
+  AsmTemplate(std::vector<Node> nodes, std::vector<TemplateAxis> axes)
+      : nodes_(std::move(nodes)), axes_(std::move(axes)) {}
+
+public:
+  static std::optional<AsmTemplate> parse(std::string const &source);
+
+  std::vector<TemplateAxis> const &axes() const { return axes_; }
+  size_t case_count() const;
+  std::vector<TemplateCase> expand() const;
+};
+
+} // namespace ib
@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <spdlog/spdlog.h>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "bootstrap.hpp"
+#include "estimator.hpp"
+#include "platform.hpp"
+#include "trace.hpp"
+#include "uuid.hpp"
+
+namespace ib::rt {
+
+namespace {
+
+inline uint64_t splitmix64(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+// lowbias32, 32 bit multiplies only so neon keeps four lanes per register
+inline uint32_t hash32(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7FEB352DU;
+  x ^= x >> 15;
+  x *= 0x846CA68BU;
+  x ^= x >> 16;
+  return x;
+}
+
+// draw one resample into out. index generation hashes the counter twice, a
+// key half per round so streams are not shifted copies of each other. no loop
+// carried state and 32x32 bit multiplies, so the first loop vectorizes when
+// optimized and the second one becomes a gather.
+double_t resample(double_t const *samples, uint32_t n, uint64_t key,
+                  double_t *out) {
+  constexpr uint32_t BlockSize = 64U;
+  uint32_t const key_low = static_cast<uint32_t>(key);
+  uint32_t const key_high = static_cast<uint32_t>(key >> 32);
+  uint32_t indexes[BlockSize];
+  double_t sum = 0.0;
+  for (uint32_t base = 0; base < n; base += BlockSize) {
+    uint32_t const len = std::min(BlockSize, n - base);
+    for (uint32_t i = 0; i < len; i++) {
+      uint32_t const r = hash32(hash32(base + i + key_low) ^ key_high);
+      // n <= 1 << 16, the product of the high half and n fits 32 bits
+      indexes[i] = ((r >> 16) * n) >> 16;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+      double_t const v = samples[indexes[i]];
+      out[base + i] = v;
+      sum += v;
+    }
+  }
+  return sum / static_cast<double_t>(n);
+}
+
+ConfidenceInterval percentile_interval(std::vector<double_t> &estimates) {
+  constexpr double_t Alpha = 0.05;
+  std::sort(estimates.begin(), estimates.end());
+  double_t const last = static_cast<double_t>(estimates.size() - 1);
+  size_t const lower = static_cast<size_t>(std::floor(last * Alpha / 2.0));
+  size_t const upper =
+      static_cast<size_t>(std::ceil(last * (1.0 - Alpha / 2.0)));
+  return {estimates[lower], estimates[upper]};
+}
+
+} // namespace
+
+BootstrapPool::BootstrapPool(size_t helper_count,
+                             std::function<void()> const &init) {
+  for (size_t i = 0; i < helper_count; i++) {
+    threads_.emplace_back([this, init]() {
+      init();
+      uint64_t seen = 0U;
+      while (true) {
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          start_cv_.wait(lock,
+                         [&]() { return stop_ || generation_ != seen; });
+          if (stop_)
+            return;
+          seen = generation_;
+        }
+        drain();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--busy_ == 0U)
+          done_cv_.notify_all();
+      }
+    });
+  }
+}
+
+BootstrapPool::~BootstrapPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_cv_.notify_all();
+  for (std::thread &thread : threads_)
+    thread.join();
+}
+
+void BootstrapPool::drain() {
+  for (size_t i = next_task_.fetch_add(1U); i < task_count_;
+       i = next_task_.fetch_add(1U))
+    (*task_)(i);
+}
+
+void BootstrapPool::run(size_t count,
+                        std::function<void(size_t)> const &task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    task_count_ = count;
+    next_task_.store(0U);
+    busy_ = threads_.size();
+    generation_++;
+  }
+  start_cv_.notify_all();
+  drain();
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_cv_.wait(lock, [&]() { return busy_ == 0U; });
+  task_ = nullptr;
+}
+
+BootstrapResult bootstrap(std::vector<double_t> const &samples,
+                          size_t resample_count, BootstrapPool &pool,
+                          uint64_t seed) {
+  constexpr size_t ChunkSize = 64U;
+  size_t const n = samples.size();
+  std::vector<double_t> means(resample_count);
+  std::vector<double_t> medians(resample_count);
+  pool.run((resample_count + ChunkSize - 1U) / ChunkSize, [&](size_t chunk) {
+    std::vector<double_t> buffer(n);
+    size_t const end = std::min((chunk + 1U) * ChunkSize, resample_count);
+    for (size_t i = chunk * ChunkSize; i < end; i++) {
+      // sample buffers hold at most 1 << 16 samples, see resample
+      means[i] = resample(samples.data(), static_cast<uint32_t>(n),
+                          splitmix64(seed ^ i), buffer.data());
+      medians[i] = median(buffer);
+    }
+  });
+
+  BootstrapResult result{};
+  result.n_ = n;
+  result.robust_ = robust_estimate(samples);
+  result.mean_ = percentile_interval(means);
+  result.median_ = percentile_interval(medians);
+  return result;
+}
+
+BootstrapWorker::BootstrapWorker(size_t resample_count, size_t parallelism)
+    : resample_count_(resample_count), parallelism_(parallelism) {
+  if (parallelism_ == 0U) {
+    // leave cores for executor and statistic
+    unsigned const cores = std::thread::hardware_concurrency();
+    parallelism_ = cores > 4U ? cores / 2U : 1U;
+  }
+}
+
+void BootstrapWorker::submit(UUID uuid, std::vector<double_t> samples) {
+  if (samples.size() < MinSampleCount)
+    return;
+  job_queue_.push(std::unique_ptr<BootstrapJob>{
+      new BootstrapJob{.uuid_ = uuid, .samples_ = std::move(samples)}});
+}
+
+std::optional<BootstrapResult> BootstrapWorker::get(UUID uuid) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto const it = results_.find(uuid);
+  if (it == results_.end())
+    return std::nullopt;
+  return it->second;
+}
+
+void BootstrapWorker::start(std::vector<size_t> const &cpus) {
+  auto const isolate = [&cpus]() {
+    if (!cpus.empty())
+      platform::pin_current_thread(cpus);
+    platform::lower_current_thread_priority();
+  };
+  isolate();
+  size_t const parallelism =
+      cpus.empty() ? parallelism_ : std::min(parallelism_, cpus.size());
+  BootstrapPool pool{parallelism - 1U, isolate};
+  std::random_device rd;
+  uint64_t seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+  while (true) {
+    std::unique_ptr<BootstrapJob> job = job_queue_.pop();
+    // drop stale jobs, only the newest snapshot of each case matters
+    std::map<UUID, std::unique_ptr<BootstrapJob>> jobs;
+    jobs[job->uuid_] = std::move(job);
+    for (auto &pending : job_queue_.pop_all())
+      jobs[pending->uuid_] = std::move(pending);
+
+    for (auto const &[uuid, pending] : jobs) {
+      IB_TRACE_SPAN("bootstrap");
+      seed = splitmix64(seed);
+      BootstrapResult result =
+          bootstrap(pending->samples_, resample_count_, pool, seed);
+      spdlog::debug("[bootstrap] uuid {} with {} samples", uuid, result.n_);
+      std::lock_guard<std::mutex> lock(mutex_);
+      results_[uuid] = result;
+    }
+  }
+}
+
+} // namespace ib::rt
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "estimator.hpp"
+#include "multiple_thread_queue.hpp"
+#include "uuid.hpp"
+
+namespace ib::rt {
+
+struct BootstrapResult {
+  size_t n_ = 0U;
+  RobustEstimate robust_;
+  ConfidenceInterval mean_;
+  ConfidenceInterval median_;
+};
+
+struct BootstrapJob {
+  UUID uuid_;
+  std::vector<double_t> samples_;
+};
+
+// persistent helper threads, the caller takes part in every run
+class BootstrapPool {
+  std::mutex mutex_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+  std::function<void(size_t)> const *task_ = nullptr;
+  size_t task_count_ = 0U;
+  std::atomic<size_t> next_task_{0U};
+  // helpers still working on the current generation
+  size_t busy_ = 0U;
+  uint64_t generation_ = 0U;
+  bool stop_ = false;
+  std::vector<std::thread> threads_;
+
+  void drain();
+
+public:
+  // init runs first on every helper, e.g. to pin it
+  BootstrapPool(size_t helper_count, std::function<void()> const &init);
+  ~BootstrapPool();
+  BootstrapPool(BootstrapPool const &) = delete;
+  BootstrapPool &operator=(BootstrapPool const &) = delete;
+
+  // task(i) for every i below count, returns when all are done
+  void run(size_t count, std::function<void(size_t)> const &task);
+};
+
+// percentile bootstrap over raw samples, run on its own thread so resampling
+// never competes with the executor
+class BootstrapWorker {
+  MultipleThreadQueue<BootstrapJob> job_queue_;
+  mutable std::mutex mutex_;
+  std::map<UUID, BootstrapResult> results_;
+  size_t resample_count_;
+  size_t parallelism_;
+
+public:
+  static constexpr size_t MinSampleCount = 10U;
+
+  explicit BootstrapWorker(size_t resample_count = 2000U,
+                           size_t parallelism = 0U);
+
+  void submit(UUID uuid, std::vector<double_t> samples);
+  std::optional<BootstrapResult> get(UUID uuid) const;
+
+  // worker and its pool run at low priority on cpus, empty keeps affinity
+  void start(std::vector<size_t> const &cpus = {});
+};
+
+BootstrapResult bootstrap(std::vector<double_t> const &samples,
+                          size_t resample_count, BootstrapPool &pool,
+                          uint64_t seed);
+
+} // namespace ib::rt
@@ -0,0 +1,44 @@
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <spdlog/spdlog.h>
+#include <string>
+
+#include "calibration.hpp"
+#include "platform.hpp"
+
+namespace ib::rt {
+
+Calibration::Calibration()
+    : cycles_per_tick_(std::numeric_limits<double_t>::quiet_NaN()),
+      ns_per_tick_(1e9 / static_cast<double_t>(platform::timer_frequency())) {
+  spdlog::info("[calibration] timer frequency {} Hz",
+               platform::timer_frequency());
+}
+
+std::string Calibration::chain_asm() {
+  std::string chain{};
+  for (uint64_t i = 0; i < ChainLength; i++)
+    chain += "add x9, x9, #1\n";
+  return chain;
+}
+
+bool Calibration::update(int64_t chain_ticks, uint64_t repeat_count) {
+  double_t const cycles_per_tick =
+      static_cast<double_t>(ChainLength * repeat_count) /
+      static_cast<double_t>(chain_ticks);
+  bool const changed =
+      calibrated() && std::abs(cycles_per_tick - cycles_per_tick_) >
+                          cycles_per_tick_ * DriftTolerance;
+  if (!calibrated() || changed)
+    spdlog::info("[calibration] {} core cycles per tick, core clock {} MHz",
+                 cycles_per_tick, cycles_per_tick / ns_per_tick_ * 1e3);
+  if (changed)
+    spdlog::warn("[calibration] frequency changed from {} to {} cycles per "
+                 "tick",
+                 cycles_per_tick_, cycles_per_tick);
+  cycles_per_tick_ = cycles_per_tick;
+  return changed;
+}
+
+} // namespace ib::rt
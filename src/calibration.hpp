@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+namespace ib::rt {
+
+// convert timer ticks to core cycles. a chain of dependent adds retires one
+// add per core cycle, measuring it in ticks gives the current ratio.
+class Calibration {
+  double_t cycles_per_tick_;
+  double_t ns_per_tick_;
+
+public:
+  static constexpr uint64_t ChainLength = 512U;
+  static constexpr int64_t MinTicks = 2000;
+  // relative change of ratio treated as frequency change
+  static constexpr double_t DriftTolerance = 0.02;
+
+  Calibration();
+
+  static std::string chain_asm();
+
+  // returns true when frequency changed since previous update
+  bool update(int64_t chain_ticks, uint64_t repeat_count);
+
+  bool calibrated() const { return !std::isnan(cycles_per_tick_); }
+  double_t cycles_per_tick() const { return cycles_per_tick_; }
+  double_t ns_per_tick() const { return ns_per_tick_; }
+};
+
+} // namespace ib::rt
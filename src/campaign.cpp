@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <poll.h>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "campaign.hpp"
+#include "options.hpp"
+#include "platform.hpp"
+#include "snapshot.hpp"
+#include "unix_socket.hpp"
+#include "uuid.hpp"
+
+namespace ib {
+
+bool in_shard(Options const &options, UUID uuid) {
+  if (!options.shard_.has_value() || uuid == UUIDUtils::control_group_uuid)
+    return true;
+  return uuid % options.shard_->count_ == options.shard_->index_;
+}
+
+namespace {
+
+struct Worker {
+  pid_t pid_ = -1;
+  int fd_ = -1;
+  std::optional<rt::Snapshot> partial_;
+};
+
+// cpus grouped by physical core, each group sorted
+std::vector<std::vector<size_t>> physical_cores() {
+  std::vector<std::vector<size_t>> cores{};
+  std::vector<bool> seen(platform::cpu_count(), false);
+  for (size_t cpu = 0; cpu < seen.size(); cpu++) {
+    if (seen[cpu])
+      continue;
+    std::vector<size_t> core = platform::smt_siblings(cpu);
+    std::erase_if(core, [&](size_t sibling) {
+      return sibling >= seen.size() || seen[sibling];
+    });
+    core.push_back(cpu);
+    std::sort(core.begin(), core.end());
+    for (size_t member : core)
+      seen[member] = true;
+    cores.push_back(std::move(core));
+  }
+  return cores;
+}
+
+// one NUMA node per worker when there are enough nodes, otherwise split
+// physical cores into contiguous blocks so SMT siblings stay in the same
+// worker. with fewer cores than workers siblings are split. nullopt when
+// there are fewer cpus than workers
+std::optional<std::vector<std::vector<size_t>>> plan_cpus(size_t shard_count) {
+  std::vector<std::vector<size_t>> const nodes = platform::numa_nodes();
+  std::vector<std::vector<size_t>> plan{};
+  if (nodes.size() >= shard_count) {
+    for (size_t i = 0; i < shard_count; i++)
+      plan.push_back(nodes[i]);
+    return plan;
+  }
+  std::vector<std::vector<size_t>> groups = physical_cores();
+  if (groups.size() < shard_count) {
+    groups.clear();
+    for (size_t cpu = 0; cpu < platform::cpu_count(); cpu++)
+      groups.push_back({cpu});
+  }
+  if (groups.size() < shard_count)
+    return std::nullopt;
+  for (size_t i = 0; i < shard_count; i++) {
+    std::vector<size_t> cpus{};
+    for (size_t j = i * groups.size() / shard_count;
+         j < (i + 1U) * groups.size() / shard_count; j++)
+      cpus.insert(cpus.end(), groups[j].begin(), groups[j].end());
+    plan.push_back(std::move(cpus));
+  }
+  return plan;
+}
+
+// forward everything except the options only the coordinator owns and the
+// per worker ones. a worker measures on the first cpu of its block and
+// traces to its own file
+std::vector<std::string> worker_arguments(int argc, char **argv) {
+  std::vector<std::string> args{};
+  for (int i = 1; i < argc; i++) {
+    std::string_view const arg = argv[i];
+    if (arg == "--shards" || arg == "--snapshot" || arg == "--cpus" ||
+        arg == "--shard" || arg == "--report-socket" ||
+        arg == "--victim-cpu" || arg == "--trace") {
+      i++;
+      continue;
+    }
+    args.emplace_back(arg);
+  }
+  return args;
+}
+
+pid_t spawn_worker(char const *program, std::vector<std::string> args) {
+  pid_t const pid = fork();
+  if (pid != 0)
+    return pid;
+  std::vector<char *> child_argv{const_cast<char *>(program)};
+  for (std::string &arg : args)
+    child_argv.push_back(arg.data());
+  child_argv.push_back(nullptr);
+  execvp(program, child_argv.data());
+  std::fprintf(stderr, "exec %s failed: %s\n", program, std::strerror(errno));
+  _exit(127);
+}
+
+} // namespace
+
+int run_campaign(Options const &options, int argc, char **argv) {
+  size_t const shard_count = options.shard_count_;
+  std::optional<std::vector<std::vector<size_t>>> const cpu_plan =
+      plan_cpus(shard_count);
+  if (!cpu_plan.has_value()) {
+    spdlog::error("[campaign] {} shards but only {} cpus", shard_count,
+                  platform::cpu_count());
+    return EXIT_FAILURE;
+  }
+  std::string const socket_path =
+      "/tmp/instr_bench." + std::to_string(getpid()) + ".sock";
+  int const listen_fd = listen_unix_socket(socket_path);
+  if (listen_fd < 0)
+    return EXIT_FAILURE;
+
+  std::vector<std::string> const common_args = worker_arguments(argc, argv);
+  std::map<size_t, Worker> workers{};
+  for (size_t i = 0; i < shard_count; i++) {
+    std::vector<std::string> args = common_args;
+    std::string const shard =
+        std::to_string(i) + "/" + std::to_string(shard_count);
+    args.insert(args.end(), {"--shard", shard, "--report-socket", socket_path,
+                             "--cpus",
+                             platform::format_cpu_list(cpu_plan.value()[i])});
+    if (options.trace_path_.has_value())
+      args.insert(args.end(), {"--trace", options.trace_path_.value() + "." +
+                                              std::to_string(i)});
+    pid_t const pid = spawn_worker(argv[0], std::move(args));
+    if (pid < 0) {
+      spdlog::error("[campaign] fork failed: {}", std::strerror(errno));
+      return EXIT_FAILURE;
+    }
+    spdlog::info("[campaign] shard {} pid {} cpus {}", i, pid,
+                 platform::format_cpu_list(cpu_plan.value()[i]));
+    workers[i].pid_ = pid;
+  }
+
+  std::vector<int> pending_fds{};
+  auto last_report_time = std::chrono::steady_clock::now();
+  size_t alive_count = shard_count;
+  bool worker_failed = false;
+  while (alive_count > 0) {
+    std::vector<pollfd> fds{{.fd = listen_fd, .events = POLLIN, .revents = 0}};
+    for (int fd : pending_fds)
+      fds.push_back({.fd = fd, .events = POLLIN, .revents = 0});
+    for (auto const &[index, worker] : workers)
+      if (worker.fd_ >= 0)
+        fds.push_back({.fd = worker.fd_, .events = POLLIN, .revents = 0});
+    if (poll(fds.data(), fds.size(), 1000) < 0 && errno != EINTR) {
+      spdlog::error("[campaign] poll failed: {}", std::strerror(errno));
+      return EXIT_FAILURE;
+    }
+    for (pollfd const &pfd : fds) {
+      if ((pfd.revents & (POLLIN | POLLHUP)) == 0)
+        continue;
+      if (pfd.fd == listen_fd) {
+        int const fd = accept(listen_fd, nullptr, nullptr);
+        if (fd >= 0)
+          pending_fds.push_back(fd);
+        continue;
+      }
+      std::optional<std::string> const frame = recv_frame(pfd.fd);
+      auto const pending_it =
+          std::find(pending_fds.begin(), pending_fds.end(), pfd.fd);
+      if (pending_it != pending_fds.end()) {
+        // first frame of a connection is the shard index
+        pending_fds.erase(pending_it);
+        size_t const index =
+            frame.has_value() ? std::strtoul(frame->c_str(), nullptr, 10)
+                              : shard_count;
+        if (!workers.contains(index)) {
+          close(pfd.fd);
+          continue;
+        }
+        workers.at(index).fd_ = pfd.fd;
+        continue;
+      }
+      for (auto &[index, worker] : workers) {
+        if (worker.fd_ != pfd.fd)
+          continue;
+        if (!frame.has_value()) {
+          close(worker.fd_);
+          worker.fd_ = -1;
+          break;
+        }
+        // partials are cumulative, the latest one replaces the previous
+        std::optional<rt::Snapshot> partial = rt::deserialize_snapshot(*frame);
+        if (partial.has_value())
+          worker.partial_ = std::move(partial);
+        break;
+      }
+    }
+
+    int status = 0;
+    pid_t pid = 0;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+      for (auto &[index, worker] : workers) {
+        if (worker.pid_ != pid)
+          continue;
+        if (WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS) {
+          spdlog::info("[campaign] shard {} pid {} exited", index, pid);
+        } else {
+          spdlog::error("[campaign] shard {} pid {} exited with status {}",
+                        index, pid, status);
+          worker_failed = true;
+        }
+        worker.pid_ = -1;
+        alive_count--;
+      }
+    }
+
+    auto const now = std::chrono::steady_clock::now();
+    if (now - last_report_time < std::chrono::seconds{1} && alive_count > 0)
+      continue;
+    last_report_time = now;
+    rt::Snapshot merged{};
+    for (auto const &[index, worker] : workers)
+      if (worker.partial_.has_value())
+        rt::merge_snapshot(merged, worker.partial_.value());
+    spdlog::info("\x1b[2J\x1b[H");
+    spdlog::info("=======CAMPAIGN {} shards, {} alive========", shard_count,
+                 alive_count);
+    rt::log_snapshot(merged);
+    if (options.snapshot_path_.has_value())
+      rt::write_snapshot(options.snapshot_path_.value(), merged);
+  }
+  close(listen_fd);
+  unlink(socket_path.c_str());
+  return worker_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+} // namespace ib
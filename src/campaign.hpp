@@ -0,0 +1,15 @@
+#pragma once
+
+#include "options.hpp"
+#include "uuid.hpp"
+
+namespace ib {
+
+// control group is part of every shard
+bool in_shard(Options const &options, UUID uuid);
+
+// launch one worker process per shard, merge their partial statistics and
+// report the merged result. returns exit code.
+int run_campaign(Options const &options, int argc, char **argv);
+
+} // namespace ib
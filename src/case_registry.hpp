@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "uuid.hpp"
+
+namespace ib {
+
+struct CaseInfo {
+  // template name, empty for hand written cases
+  std::string group_;
+  std::vector<std::pair<std::string, std::string>> params_;
+  std::string asm_;
+};
+
+// description of each case, shared between suite building and reporting
+class CaseRegistry {
+  mutable std::mutex mutex_;
+  std::map<UUID, CaseInfo> cases_;
+  std::map<std::string, std::vector<UUID>> groups_;
+
+public:
+  void add(UUID uuid, CaseInfo info) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!info.group_.empty())
+      groups_[info.group_].push_back(uuid);
+    cases_.insert_or_assign(uuid, std::move(info));
+  }
+
+  std::optional<CaseInfo> get(UUID uuid) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto const it = cases_.find(uuid);
+    if (it == cases_.end())
+      return std::nullopt;
+    return it->second;
+  }
+
+  void remove(UUID uuid) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto const it = cases_.find(uuid);
+    if (it == cases_.end())
+      return;
+    if (!it->second.group_.empty()) {
+      std::vector<UUID> &group = groups_[it->second.group_];
+      group.erase(std::remove(group.begin(), group.end(), uuid), group.end());
+      if (group.empty())
+        groups_.erase(it->second.group_);
+    }
+    cases_.erase(it);
+  }
+
+  std::vector<UUID> uuids() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<UUID> uuids{};
+    for (auto const &[uuid, info] : cases_)
+      uuids.push_back(uuid);
+    return uuids;
+  }
+
+  // asm of hand written cases, "group(name=value, ...)" for template cases
+  std::string label(UUID uuid) const {
+    std::optional<CaseInfo> const info = get(uuid);
+    if (!info.has_value())
+      return "";
+    if (info->group_.empty())
+      return info->asm_;
+    std::string label = info->group_ + "(";
+    for (size_t i = 0; i < info->params_.size(); i++) {
+      if (i > 0)
+        label += ", ";
+      label += info->params_[i].first + "=" + info->params_[i].second;
+    }
+    return label + ")";
+  }
+
+  std::map<std::string, std::vector<UUID>> groups() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return groups_;
+  }
+};
+
+} // namespace ib
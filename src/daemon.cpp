@@ -0,0 +1,158 @@
+#include <charconv>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <memory>
+#include <optional>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "case_registry.hpp"
+#include "daemon.hpp"
+#include "estimator.hpp"
+#include "statistic.hpp"
+#include "unix_socket.hpp"
+#include "uuid.hpp"
+
+namespace ib {
+
+namespace {
+
+// first word and the remainder with leading whitespace removed
+std::pair<std::string_view, std::string_view> split(std::string_view str) {
+  constexpr std::string_view Whitespace = " \t\r\n";
+  size_t const begin = str.find_first_not_of(Whitespace);
+  if (begin == std::string_view::npos)
+    return {};
+  str.remove_prefix(begin);
+  size_t const end = str.find_first_of(Whitespace);
+  if (end == std::string_view::npos)
+    return {str, {}};
+  std::string_view rest = str.substr(end);
+  size_t const rest_begin = rest.find_first_not_of(Whitespace);
+  rest.remove_prefix(rest_begin == std::string_view::npos ? rest.size()
+                                                          : rest_begin);
+  return {str.substr(0, end), rest};
+}
+
+std::optional<UUID> parse_uuid(std::string_view str) {
+  UUID uuid = 0U;
+  auto const [ptr, ec] =
+      std::from_chars(str.data(), str.data() + str.size(), uuid);
+  if (ec != std::errc{} || ptr != str.data() + str.size())
+    return std::nullopt;
+  return uuid;
+}
+
+} // namespace
+
+std::string Daemon::handle(std::string const &request) {
+  auto const [command, argument] = split(request);
+  if (command == "add") {
+    if (argument.empty())
+      return "error missing asm";
+    std::optional<UUID> const uuid = suite_.add_target(std::string{argument});
+    if (!uuid.has_value())
+      return "error failed to assemble";
+    return fmt::format("ok {}", uuid.value());
+  }
+  if (command == "template") {
+    auto const [name, source] = split(argument);
+    if (name.empty() || source.empty())
+      return "error missing template name or source";
+    std::optional<TemplateResult> const result =
+        suite_.add_template(std::string{name}, std::string{source});
+    if (!result.has_value())
+      return "error invalid template";
+    std::string reply = "ok";
+    for (UUID uuid : result->uuids_)
+      reply += fmt::format(" {}", uuid);
+    for (std::string const &params : result->failed_)
+      reply += fmt::format("\nfailed {}", params);
+    return reply;
+  }
+  if (command == "replace") {
+    auto const [uuid_str, asm_str] = split(argument);
+    std::optional<UUID> const old_uuid = parse_uuid(uuid_str);
+    if (!old_uuid.has_value())
+      return "error invalid uuid";
+    if (asm_str.empty())
+      return "error missing asm";
+    // add first, a snippet that does not assemble keeps the old one running
+    std::optional<UUID> const new_uuid =
+        suite_.add_target(std::string{asm_str});
+    if (!new_uuid.has_value())
+      return "error failed to assemble";
+    if (new_uuid.value() != old_uuid.value())
+      suite_.cancel(old_uuid.value());
+    return fmt::format("ok {}", new_uuid.value());
+  }
+  if (command == "cancel") {
+    std::optional<UUID> const uuid = parse_uuid(argument);
+    if (!uuid.has_value())
+      return "error invalid uuid";
+    if (!suite_.cancel(uuid.value()))
+      return "error unknown uuid";
+    return "ok";
+  }
+  if (command == "list") {
+    std::string reply = "ok";
+    for (UUID uuid : case_registry_.uuids())
+      if (uuid != UUIDUtils::control_group_uuid)
+        reply += fmt::format("\n{} {}", uuid, case_registry_.label(uuid));
+    return reply;
+  }
+  if (command == "stats") {
+    std::string reply = "ok";
+    std::shared_ptr<rt::Report const> const report = report_buffer_.latest();
+    for (auto const &[uuid, case_report] : *report) {
+      // cancelled cases keep their aggregates but are not reported
+      if (!case_registry_.get(uuid).has_value())
+        continue;
+      rt::Stat const &stat = case_report.stat_;
+      reply += fmt::format("\n{} n={} mean={:.3f} median={:.3f} ci={} {}", uuid,
+                           stat.count(), stat.avr(), case_report.median_,
+                           stat.confidence_interval(),
+                           case_registry_.label(uuid));
+    }
+    return reply;
+  }
+  return fmt::format("error unknown command \"{}\"", command);
+}
+
+void Daemon::serve(int fd) {
+  while (true) {
+    std::optional<std::string> const request = recv_frame(fd);
+    if (!request.has_value())
+      break;
+    spdlog::debug("[daemon] request \"{}\"", request.value());
+    if (!send_frame(fd, handle(request.value())))
+      break;
+  }
+  close(fd);
+}
+
+void Daemon::start() {
+  int const listen_fd = listen_unix_socket(options_.daemon_socket_.value());
+  if (listen_fd < 0) {
+    spdlog::error("[daemon] failed to listen on {}",
+                  options_.daemon_socket_.value());
+    std::abort();
+  }
+  spdlog::info("[daemon] listening on {}", options_.daemon_socket_.value());
+  while (true) {
+    int const fd = accept(listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+      spdlog::warn("[daemon] accept failed");
+      continue;
+    }
+    std::thread{[this, fd]() { serve(fd); }}.detach();
+  }
+}
+
+} // namespace ib
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+
+#include "case_registry.hpp"
+#include "options.hpp"
+#include "statistic.hpp"
+#include "suite.hpp"
+
+namespace ib {
+
+// serve a running benchmark over a unix socket, one text request per frame
+// and one reply frame starting with "ok" or "error":
+//   add <asm>                  measure snippet, replies its uuid
+//   template <name> <source>   expand template, replies uuids and a
+//                              "failed <params>" line per invalid variant
+//   replace <uuid> <asm>       measure new snippet instead of uuid
+//   cancel <uuid>              stop measuring uuid
+//   list                       uuid and label of every case
+//   stats                      aggregates of every case
+// each client gets its own thread, so assembling never blocks other clients
+// or the executor.
+class Daemon {
+  Options const &options_;
+  Suite &suite_;
+  rt::ReportBuffer const &report_buffer_;
+  CaseRegistry const &case_registry_;
+
+  std::string handle(std::string const &request);
+  void serve(int fd);
+
+public:
+  explicit Daemon(Options const &options, Suite &suite,
+                  rt::ReportBuffer const &report_buffer,
+                  CaseRegistry const &case_registry)
+      : options_(options), suite_(suite), report_buffer_(report_buffer),
+        case_registry_(case_registry) {}
+
+  void start();
+};
+
+} // namespace ib
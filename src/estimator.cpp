@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <fmt/format.h>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "estimator.hpp"
+
+fmt::basic_appender<char> fmt::formatter<ib::rt::ConfidenceInterval>::format(
+    const ib::rt::ConfidenceInterval &confidence_interval,
+    format_context &ctx) const {
+  return fmt::format_to(ctx.out(), "[{}, {}]", confidence_interval.lower_bound,
+                        confidence_interval.upper_bound);
+}
+
+namespace ib::rt {
+
+double_t median(std::vector<double_t> &samples) {
+  if (samples.empty())
+    return std::numeric_limits<double_t>::quiet_NaN();
+  size_t const mid = samples.size() / 2;
+  std::nth_element(samples.begin(), samples.begin() + mid, samples.end());
+  double_t const upper = samples[mid];
+  if (samples.size() % 2 == 1)
+    return upper;
+  double_t const lower =
+      *std::max_element(samples.begin(), samples.begin() + mid);
+  return (lower + upper) / 2.0;
+}
+
+double_t trimmed_mean(std::vector<double_t> &samples, double_t trim) {
+  if (samples.empty())
+    return std::numeric_limits<double_t>::quiet_NaN();
+  std::sort(samples.begin(), samples.end());
+  size_t const cut = static_cast<size_t>(
+      std::floor(static_cast<double_t>(samples.size()) * trim));
+  if (cut * 2 >= samples.size())
+    return median(samples);
+  double_t const sum =
+      std::accumulate(samples.begin() + cut, samples.end() - cut, 0.0);
+  return sum / static_cast<double_t>(samples.size() - cut * 2);
+}
+
+double_t median_absolute_deviation(std::vector<double_t> &samples,
+                                   double_t median_value) {
+  for (double_t &v : samples)
+    v = std::abs(v - median_value);
+  return median(samples);
+}
+
+double_t histogram_mode(std::vector<double_t> const &samples,
+                        size_t bin_count) {
+  if (samples.empty() || bin_count == 0)
+    return std::numeric_limits<double_t>::quiet_NaN();
+  auto const [min_it, max_it] =
+      std::minmax_element(samples.begin(), samples.end());
+  double_t const lower = *min_it;
+  double_t const width = (*max_it - lower) / static_cast<double_t>(bin_count);
+  if (width <= 0.0)
+    return lower;
+  std::vector<size_t> bins(bin_count, 0U);
+  for (double_t v : samples) {
+    size_t const bin =
+        std::min(static_cast<size_t>((v - lower) / width), bin_count - 1);
+    bins[bin]++;
+  }
+  size_t const densest = static_cast<size_t>(
+      std::max_element(bins.begin(), bins.end()) - bins.begin());
+  return lower + (static_cast<double_t>(densest) + 0.5) * width;
+}
+
+RobustEstimate robust_estimate(std::vector<double_t> samples) {
+  constexpr double_t Trim = 0.1;
+  constexpr size_t ModeBinCount = 1000;
+  RobustEstimate estimate{};
+  estimate.mode_ = histogram_mode(samples, ModeBinCount);
+  estimate.trimmed_mean_ = trimmed_mean(samples, Trim);
+  estimate.median_ = median(samples);
+  estimate.mad_ = median_absolute_deviation(samples, estimate.median_);
+  return estimate;
+}
+
+} // namespace ib::rt
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <fmt/base.h>
+#include <vector>
+
+namespace ib::rt {
+
+struct ConfidenceInterval {
+  double_t lower_bound = 0.0;
+  double_t upper_bound = 0.0;
+};
+
+struct RobustEstimate {
+  double_t median_ = 0.0;
+  double_t trimmed_mean_ = 0.0;
+  double_t mad_ = 0.0;
+  double_t mode_ = 0.0;
+};
+
+// median of samples, samples will be reordered
+double_t median(std::vector<double_t> &samples);
+
+// mean of samples in [trim, 1 - trim] quantile, samples will be sorted
+double_t trimmed_mean(std::vector<double_t> &samples, double_t trim);
+
+// median absolute deviation around median, samples will be reordered
+double_t median_absolute_deviation(std::vector<double_t> &samples,
+                                   double_t median);
+
+// center of the densest bin in a histogram with bin_count bins
+double_t histogram_mode(std::vector<double_t> const &samples,
+                        size_t bin_count);
+
+RobustEstimate robust_estimate(std::vector<double_t> samples);
+
+} // namespace ib::rt
+
+template <> struct fmt::formatter<ib::rt::ConfidenceInterval> {
+  constexpr auto parse(format_parse_context &ctx) { return ctx.begin(); }
+  fmt::basic_appender<char>
+  format(const ib::rt::ConfidenceInterval &confidence_interval,
+         format_context &ctx) const;
+};
@@ -1,5 +1,4 @@
 #include <algorithm>
-#include <cassert>
 #include <chrono>
 #include <cmath>
 #include <cstdint>
@@ -11,146 +10,282 @@
 #include <memory>
 #include <optional>
 #include <random>
+#include <set>
 #include <spdlog/spdlog.h>
-#include <sys/mman.h>
 #include <thread>
-#include <unistd.h>
 #include <utility>
 #include <vector>
 
+#include "calibration.hpp"
 #include "executor.hpp"
+#include "initial_state.hpp"
+#include "interference.hpp"
+#include "isolated_runner.hpp"
+#include "llvm.hpp"
 #include "machine_code.hpp"
+#include "mmap_raii.hpp"
+#include "options.hpp"
+#include "platform.hpp"
 #include "statistic.hpp"
+#include "trace.hpp"
+#include "trampoline.hpp"
 #include "uuid.hpp"
 
-extern "C" void trampoline(int64_t *result, void *machine_code_address,
-                           uint64_t repeat_count);
+namespace ib::rt {
 
-static size_t get_page_size() {
-  static size_t const page_size = static_cast<size_t>(sysconf(_SC_PAGE_SIZE));
-  return page_size;
-}
+// two successive runs within this relative difference are warm, with a
+// floor of a few ticks for loops shorter than the timer resolution
+static constexpr double_t WarmTolerance = 0.02;
+static constexpr int64_t WarmSlackTicks = 2;
+static constexpr size_t MaxRuns = 8U;
+
+struct RunContext {
+  InitialState const &initial_state_;
+  // writable copy, snippets may store to scratch memory
+  InitialState state_;
+
+  explicit RunContext(InitialState const &initial_state)
+      : initial_state_(initial_state), state_(initial_state) {}
+
+  // every run starts from the configured state, not the previous run's
+  // stores. outside the timed region of the trampoline
+  InitialState *reset() {
+    state_ = initial_state_;
+    return &state_;
+  }
+};
 
-static size_t round_to_page_size(size_t size) {
-  size_t const page_size = get_page_size();
-  return (size + page_size - 1) & ~(page_size - 1);
+// the first run always pays for cold caches and predictors. keep running
+// until the result settles instead of discarding a fixed number of runs
+static int64_t execute_impl(void const *exec_mem, uint64_t repeat_count,
+                            void *context) {
+  RunContext *const run_context = static_cast<RunContext *>(context);
+  void *const code = const_cast<void *>(exec_mem);
+  int64_t previous = 0;
+  trampoline(&previous, code, repeat_count, run_context->reset());
+  int64_t result = previous;
+  for (size_t run = 1U; run < MaxRuns; run++) {
+    trampoline(&result, code, repeat_count, run_context->reset());
+    int64_t const slack = std::max(
+        WarmSlackTicks,
+        static_cast<int64_t>(static_cast<double_t>(previous) * WarmTolerance));
+    if (std::abs(result - previous) <= slack)
+      break;
+    previous = result;
+  }
+  return result;
 }
 
-namespace ib::rt {
+// execute in process, or in an isolated worker when enabled
+class Runner {
+  // keeps the budget sane for huge repeat counts
+  static constexpr std::chrono::hours MaxBudget{24};
 
-namespace {
+  RunContext run_context_;
+  std::unique_ptr<IsolatedRunner> isolated_runner_;
+  uint64_t watchdog_cycles_;
+  Calibration const &calibration_;
 
-class MMapRAII {
-  void *exec_mem_;
-  size_t code_size_;
+  // watchdog cycles in ns at the calibrated frequency, halved for frequency
+  // drops, or 1 cycle per ns until calibrated. saturates instead of
+  // overflowing, plus slack for scheduling
+  std::chrono::nanoseconds budget(uint64_t repeat_count) const {
+    double_t const ns_per_cycle =
+        calibration_.calibrated()
+            ? 2.0 * calibration_.ns_per_tick() / calibration_.cycles_per_tick()
+            : 1.0;
+    double_t const ns = static_cast<double_t>(watchdog_cycles_) *
+                        static_cast<double_t>(repeat_count) *
+                        static_cast<double_t>(MaxRuns) * ns_per_cycle;
+    double_t const max_ns =
+        std::chrono::duration<double_t, std::nano>{MaxBudget}.count();
+    return std::chrono::nanoseconds{
+               static_cast<int64_t>(std::min(ns, max_ns))} +
+           std::chrono::milliseconds{100};
+  }
 
 public:
-  void *get_exec_mem() const { return exec_mem_; }
-
-  explicit MMapRAII(MachineCode const &machine_code) : exec_mem_(nullptr) {
-    code_size_ = round_to_page_size(machine_code.size());
-    spdlog::info("[mm] mmap code with RW permission");
-    exec_mem_ = mmap(nullptr, code_size_, PROT_READ | PROT_WRITE,
-                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    if (exec_mem_ == MAP_FAILED) {
-      spdlog::error("[mm] failed to allocate executable memory");
-      std::abort();
-    }
-    spdlog::info("[mm] mmaped with RW permission in [{} {}]", exec_mem_,
-                 code_size_);
-    std::memcpy(exec_mem_, machine_code.data(), code_size_);
-    spdlog::info("[mm] mprotect with RE permission in [{} {}]", exec_mem_,
-                 code_size_);
-    mprotect(exec_mem_, code_size_, PROT_READ | PROT_EXEC);
+  Runner(Options const &options, Calibration const &calibration)
+      : run_context_(options.initial_state_),
+        isolated_runner_(options.isolate_
+                             ? std::make_unique<IsolatedRunner>(
+                                   execute_impl, &run_context_)
+                             : nullptr),
+        watchdog_cycles_(options.watchdog_cycles_),
+        calibration_(calibration) {}
+  Runner(Runner const &) = delete;
+  Runner &operator=(Runner const &) = delete;
+
+  // new code is only visible to workers forked after it was mapped
+  void reload() {
+    if (isolated_runner_ != nullptr)
+      isolated_runner_->restart();
   }
-  ~MMapRAII() {
-    if (exec_mem_ != MAP_FAILED) {
-      spdlog::info("[mm] munmap [{} {}]", exec_mem_, code_size_);
-      munmap(exec_mem_, code_size_);
+
+  std::optional<int64_t> execute(UUID uuid, MMapRAII const &mmap_raii,
+                                 uint64_t repeat_count) {
+    spdlog::debug("[executor] execution with exec_mem {}",
+                  mmap_raii.get_exec_mem());
+    if (isolated_runner_ == nullptr)
+      return execute_impl(mmap_raii.get_exec_mem(), repeat_count,
+                          &run_context_);
+    IsolatedRunner::Result const result = isolated_runner_->run(
+        mmap_raii.get_exec_mem(), repeat_count, budget(repeat_count));
+    switch (result.status_) {
+    case IsolatedRunner::Status::Ok:
+      return result.value_;
+    case IsolatedRunner::Status::Crashed:
+      spdlog::error("[executor] uuid {} crashed with signal {} at {}", uuid,
+                    result.signal_, result.fault_address_);
+      return std::nullopt;
+    case IsolatedRunner::Status::Timeout:
+      spdlog::error("[executor] uuid {} exceeded budget of {} cycles per "
+                    "iteration",
+                    uuid, watchdog_cycles_);
+      return std::nullopt;
     }
+    return std::nullopt;
   }
 };
 
-} // namespace
-
-static int64_t execute_impl(MMapRAII const &mmap_raii, uint64_t repeat_count) {
-  int64_t result = 0;
-  spdlog::debug("[executor] execution with result address {} and exec_mem {}",
-                (void *)&result, mmap_raii.get_exec_mem());
-
-  trampoline(&result, mmap_raii.get_exec_mem(), repeat_count);
-  trampoline(&result, mmap_raii.get_exec_mem(), repeat_count);
-
-  // yield once to avoid time out
-  std::this_thread::yield();
-  trampoline(&result, mmap_raii.get_exec_mem(), repeat_count);
-  return result;
-}
-
 class RepeatCount {
   uint64_t count_ = 1U;
+  Runner &runner_;
   MMapRAII *baseline_mmap_raii_ = nullptr;
-  std::vector<MMapRAII *> pending_measure_repeat_cout{};
+  std::vector<std::pair<UUID, MMapRAII *>> pending_measure_repeat_cout{};
 
   void increase_count() { count_ *= 2U; }
 
-public:
-  uint64_t get_count() const {
-    assert(!pending_measure_repeat_cout.empty());
-    return count_;
+  bool calibrate(UUID uuid, MMapRAII *mmap_raii) {
+    IB_TRACE_SPAN("calibrate");
+    while (true) {
+      std::optional<int64_t> const baseline_result = runner_.execute(
+          UUIDUtils::control_group_uuid, *baseline_mmap_raii_, count_);
+      if (!baseline_result.has_value()) {
+        spdlog::error("[executor] control group failed");
+        std::abort();
+      }
+      std::optional<int64_t> const result =
+          runner_.execute(uuid, *mmap_raii, count_);
+      if (!result.has_value())
+        return false;
+      if (result.value() - baseline_result.value() >= 100)
+        return true;
+      increase_count();
+    }
   }
 
-  void set_baseline_mmap_raii(MMapRAII *baseline_mmap_raii) {
+public:
+  explicit RepeatCount(Runner &runner) : runner_(runner) {}
+
+  // stays 1 until a case has been calibrated
+  uint64_t get_count() const { return count_; }
+
+  // returns cases which failed during calibration
+  std::vector<UUID> set_baseline_mmap_raii(MMapRAII *baseline_mmap_raii) {
     baseline_mmap_raii_ = baseline_mmap_raii;
-    for (MMapRAII *mmap_raii : pending_measure_repeat_cout) {
-      while (true) {
-        int64_t const baseline_result =
-            execute_impl(*baseline_mmap_raii, count_);
-        int64_t const result =
-            execute_impl(*mmap_raii, count_) - baseline_result;
-        if (result >= 100)
-          break;
-        increase_count();
-      }
+    std::vector<UUID> failed{};
+    for (auto const &[uuid, mmap_raii] : pending_measure_repeat_cout) {
+      if (!calibrate(uuid, mmap_raii))
+        failed.push_back(uuid);
     }
+    return failed;
   }
 
-  void add_case(MMapRAII *mmap_raii) {
+  bool add_case(UUID uuid, MMapRAII *mmap_raii) {
     if (baseline_mmap_raii_ == nullptr) {
-      pending_measure_repeat_cout.push_back(mmap_raii);
-      return;
-    }
-    while (true) {
-      int64_t const baseline_result =
-          execute_impl(*baseline_mmap_raii_, count_);
-      int64_t const result = execute_impl(*mmap_raii, count_) - baseline_result;
-      if (result >= 100)
-        break;
-      increase_count();
+      pending_measure_repeat_cout.emplace_back(uuid, mmap_raii);
+      return true;
     }
+    return calibrate(uuid, mmap_raii);
   }
 };
 
+// measure dependent add chain against control group, doubling repeat count
+// until the difference is large enough. returns true on frequency change.
+static bool recalibrate(Runner &runner, Calibration &calibration,
+                        MMapRAII const &chain_mmap_raii,
+                        MMapRAII const &baseline_mmap_raii,
+                        uint64_t &repeat_count) {
+  IB_TRACE_SPAN("calibrate_clock");
+  while (true) {
+    std::optional<int64_t> const baseline = runner.execute(
+        UUIDUtils::control_group_uuid, baseline_mmap_raii, repeat_count);
+    std::optional<int64_t> const chain = runner.execute(
+        UUIDUtils::calibration_uuid, chain_mmap_raii, repeat_count);
+    if (!baseline.has_value() || !chain.has_value()) {
+      spdlog::error("[executor] calibration failed");
+      std::abort();
+    }
+    int64_t const chain_ticks = chain.value() - baseline.value();
+    if (chain_ticks >= Calibration::MinTicks)
+      return calibration.update(chain_ticks, repeat_count);
+    repeat_count *= 2U;
+  }
+}
+
 void Executor::start() {
-  RepeatCount repeat_counter{};
+  Calibration calibration{};
+  Runner runner{options_, calibration};
+  RepeatCount repeat_counter{runner};
+  uint64_t calibration_repeat_count = 1U;
+  std::unique_ptr<MachineCode> const chain_code =
+      ib::llvm::compile_snippet(Calibration::chain_asm());
+  MMapRAII const chain_mmap_raii{*chain_code};
+  std::unique_ptr<MMapRAII> aggressor_mmap_raii{};
+  std::unique_ptr<Interference> interference{};
+  if (options_.aggressor_ != AggressorKind::None) {
+    size_t const victim_cpu = options_.victim_cpu_.value_or(
+        options_.cpus_.empty() ? 0U : options_.cpus_.front());
+    platform::pin_current_thread({victim_cpu});
+    if (options_.aggressor_ == AggressorKind::Snippet) {
+      std::unique_ptr<MachineCode> const aggressor_code =
+          ib::llvm::compile_snippet(options_.aggressor_asm_);
+      if (aggressor_code == nullptr) {
+        spdlog::error("[executor] invalid aggressor snippet");
+        std::abort();
+      }
+      aggressor_mmap_raii = std::make_unique<MMapRAII>(*aggressor_code);
+    }
+    interference = std::make_unique<Interference>(
+        options_, victim_cpu,
+        aggressor_mmap_raii ? aggressor_mmap_raii->get_exec_mem() : nullptr);
+  }
+  uint64_t round_index = 0U;
   std::map<UUID, std::unique_ptr<MMapRAII>> machine_codes;
+  std::set<UUID> quarantined;
+  auto const quarantine = [&](UUID uuid) {
+    spdlog::error("[executor] quarantine uuid {}", uuid);
+    quarantined.insert(uuid);
+    machine_codes.erase(uuid);
+  };
   while (true) {
     // maintain task
     std::deque<std::unique_ptr<MachineCode>> new_machine_codes =
         machine_code_queue_.pop_all();
+    std::vector<UUID> new_uuids{};
     for (auto &machine_code : new_machine_codes) {
+      if (quarantined.contains(machine_code->uuid_)) {
+        spdlog::warn("[executor] skip quarantined uuid {}",
+                     machine_code->uuid_);
+        continue;
+      }
       spdlog::info("[executor] add machine code with uuid {}",
                    machine_code->uuid_);
-      std::unique_ptr<MMapRAII> mmap_raii =
+      machine_codes[machine_code->uuid_] =
           std::make_unique<MMapRAII>(*machine_code);
-
-      if (machine_code->uuid_ == UUIDUtils::control_group_uuid) {
-        repeat_counter.set_baseline_mmap_raii(mmap_raii.get());
-      } else {
-        repeat_counter.add_case(mmap_raii.get());
+      new_uuids.push_back(machine_code->uuid_);
+    }
+    if (!new_uuids.empty())
+      runner.reload();
+    for (UUID uuid : new_uuids) {
+      MMapRAII *mmap_raii = machine_codes.at(uuid).get();
+      if (uuid == UUIDUtils::control_group_uuid) {
+        for (UUID failed : repeat_counter.set_baseline_mmap_raii(mmap_raii))
+          quarantine(failed);
+      } else if (!repeat_counter.add_case(uuid, mmap_raii)) {
+        quarantine(uuid);
       }
-
-      machine_codes[machine_code->uuid_] = std::move(mmap_raii);
     }
     std::deque<std::unique_ptr<UUID>> cancel_uuids = cancel_queue_.pop_all();
     for (auto &cancel_uuid : cancel_uuids) {
@@ -169,6 +304,11 @@ void Executor::start() {
         continue;
       entries.emplace_back(uuid, mmap_raii.get());
     }
+    // a daemon or an empty shard idles on the control group until cases come
+    if (entries.empty()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{100});
+      continue;
+    }
     std::random_device rd;
     std::mt19937 rng{rd()};
     std::shuffle(entries.begin(), entries.end(), rng);
@@ -179,19 +319,65 @@ void Executor::start() {
     std::deque<std::unique_ptr<Sample>> samples;
     uint64_t const repeat_count = repeat_counter.get_count();
 
-    // execute
-    int64_t const baseline = execute_impl(*baseline_mmap_raii, repeat_count);
+    // execute, odd rounds run under interference
+    bool const loaded = interference != nullptr && round_index++ % 2U == 1U;
+    if (interference != nullptr) {
+      interference->set_victim_code(
+          entries.empty() ? nullptr : entries.front().second->get_exec_mem());
+      interference->set_active(loaded);
+    }
+    std::optional<int64_t> const baseline = runner.execute(
+        UUIDUtils::control_group_uuid, *baseline_mmap_raii, repeat_count);
+    if (!baseline.has_value()) {
+      spdlog::error("[executor] control group failed");
+      std::abort();
+    }
+    if (!calibration.calibrated())
+      recalibrate(runner, calibration, chain_mmap_raii, *baseline_mmap_raii,
+                  calibration_repeat_count);
+    double_t const cycles_per_tick_before = calibration.cycles_per_tick();
+    std::set<UUID> failed{};
     for (size_t i = 0; i < 4; i++) {
+      IB_TRACE_SPAN("measure");
       for (auto &[uuid, mmap_raii_ptr] : entries) {
-        int64_t const result =
-            execute_impl(*mmap_raii_ptr, repeat_count) - baseline;
-        double_t const cpu_cycle =
-            static_cast<double_t>(result) / static_cast<double_t>(repeat_count);
-        samples.push_back(std::unique_ptr<Sample>{
-            new Sample{.uuid_ = uuid, .cpu_cycle_ = cpu_cycle}});
+        if (failed.contains(uuid))
+          continue;
+        if (interference != nullptr)
+          interference->set_victim_code(mmap_raii_ptr->get_exec_mem());
+        std::optional<int64_t> const result =
+            runner.execute(uuid, *mmap_raii_ptr, repeat_count);
+        if (!result.has_value()) {
+          failed.insert(uuid);
+          continue;
+        }
+        double_t const ticks =
+            static_cast<double_t>(result.value() - baseline.value()) /
+            static_cast<double_t>(repeat_count);
+        samples.push_back(std::unique_ptr<Sample>{new Sample{
+            .uuid_ = uuid,
+            .cpu_cycle_ = 0.0,
+            .ticks_ = ticks,
+            .nanoseconds_ = ticks * calibration.ns_per_tick(),
+            .frequency_changed_ = false,
+            .loaded_ = loaded}});
       }
     }
+    if (interference != nullptr)
+      interference->set_active(false);
+    for (UUID uuid : failed)
+      quarantine(uuid);
+    // convert with the ratio around this round
+    bool const frequency_changed =
+        recalibrate(runner, calibration, chain_mmap_raii, *baseline_mmap_raii,
+                    calibration_repeat_count);
+    double_t const cycles_per_tick =
+        (cycles_per_tick_before + calibration.cycles_per_tick()) / 2.0;
+    for (auto &sample : samples) {
+      sample->cpu_cycle_ = sample->ticks_ * cycles_per_tick;
+      sample->frequency_changed_ = frequency_changed;
+    }
     // send
+    IB_TRACE_SPAN("publish");
     statistic_queue_.push_all(std::move(samples));
   }
 }
@@ -2,6 +2,7 @@
 
 #include "machine_code.hpp"
 #include "multiple_thread_queue.hpp"
+#include "options.hpp"
 #include "statistic.hpp"
 #include "uuid.hpp"
 
@@ -11,13 +12,15 @@ class Executor {
   MultipleThreadQueue<MachineCode> &machine_code_queue_;
   MultipleThreadQueue<UUID> &cancel_queue_;
   MultipleThreadQueue<Sample> &statistic_queue_;
+  Options const &options_;
 
 public:
   explicit Executor(MultipleThreadQueue<MachineCode> &queue,
                     MultipleThreadQueue<UUID> &cancel_queue,
-                    MultipleThreadQueue<Sample> &statQueue)
+                    MultipleThreadQueue<Sample> &statQueue,
+                    Options const &options)
       : machine_code_queue_(queue), cancel_queue_(cancel_queue),
-        statistic_queue_(statQueue) {}
+        statistic_queue_(statQueue), options_(options) {}
 
   void start();
 };
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ib::rt {
+
+// fixed number of bins, O(1) per sample. the range is seeded from the first
+// samples and doubles, merging neighbour bins, once more than 1% of samples
+// fall outside. rarer outliers, and any value more than twice the range away,
+// only count as underflow or overflow, so one early spike cannot stretch the
+// range for good.
+class Histogram {
+public:
+  static constexpr size_t BinCount = 64U;
+  static constexpr size_t SeedCount = 32U;
+
+private:
+  std::array<uint64_t, BinCount> bins_{};
+  std::vector<double_t> seeds_{};
+  double_t lower_ = 0.0;
+  // 0 until seeded
+  double_t width_ = 0.0;
+  uint64_t count_ = 0U;
+  uint64_t underflow_ = 0U;
+  uint64_t overflow_ = 0U;
+
+  double_t upper() const {
+    return lower_ + width_ * static_cast<double_t>(BinCount);
+  }
+
+  // [lower, upper) => [lower, upper + span)
+  void grow_up() {
+    for (size_t i = 0; i < BinCount / 2U; i++)
+      bins_[i] = bins_[2U * i] + bins_[2U * i + 1U];
+    std::fill(bins_.begin() + BinCount / 2U, bins_.end(), 0U);
+    width_ *= 2.0;
+  }
+
+  // [lower, upper) => [lower - span, upper)
+  void grow_down() {
+    constexpr size_t Half = BinCount / 2U;
+    for (size_t i = BinCount; i-- > Half;)
+      bins_[i] = bins_[2U * (i - Half)] + bins_[2U * (i - Half) + 1U];
+    std::fill(bins_.begin(), bins_.begin() + Half, 0U);
+    lower_ -= width_ * static_cast<double_t>(BinCount);
+    width_ *= 2.0;
+  }
+
+  void place(double_t v) {
+    double_t const span = upper() - lower_;
+    bool const outside = v < lower_ || v >= upper();
+    bool const far = v < lower_ - 2.0 * span || v >= upper() + 2.0 * span;
+    if (far || (outside && (underflow_ + overflow_ + 1U) * 100U <= count_)) {
+      (v < lower_ ? underflow_ : overflow_)++;
+      return;
+    }
+    while (v < lower_)
+      grow_down();
+    while (v >= upper())
+      grow_up();
+    size_t const index = static_cast<size_t>((v - lower_) / width_);
+    bins_[std::min(index, BinCount - 1U)]++;
+  }
+
+  // spread of the seeds centered in the range, with room on both sides. the
+  // outer eighths are left out so a spike among the seeds is an outlier
+  void seed() {
+    std::vector<double_t> sorted = seeds_;
+    std::sort(sorted.begin(), sorted.end());
+    double_t const min = sorted[SeedCount / 8U];
+    double_t const max = sorted[SeedCount - 1U - SeedCount / 8U];
+    double_t spread = max - min;
+    if (spread <= 0.0)
+      spread = std::max(std::abs(min) * 0.01, 1e-3);
+    lower_ = min - spread / 2.0;
+    width_ = spread * 2.0 / static_cast<double_t>(BinCount);
+    for (double_t v : seeds_)
+      place(v);
+    seeds_.clear();
+    seeds_.shrink_to_fit();
+  }
+
+public:
+  void add(double_t v) {
+    if (!std::isfinite(v))
+      return;
+    count_++;
+    if (width_ > 0.0) {
+      place(v);
+      return;
+    }
+    seeds_.push_back(v);
+    if (seeds_.size() == SeedCount)
+      seed();
+  }
+
+  bool seeded() const { return width_ > 0.0; }
+  std::array<uint64_t, BinCount> const &bins() const { return bins_; }
+  double_t lower_bound() const { return lower_; }
+  double_t upper_bound() const { return upper(); }
+  uint64_t count() const { return count_; }
+  uint64_t underflow() const { return underflow_; }
+  uint64_t overflow() const { return overflow_; }
+};
+
+} // namespace ib::rt
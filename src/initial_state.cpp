@@ -0,0 +1,107 @@
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <spdlog/spdlog.h>
+#include <string_view>
+
+#include "initial_state.hpp"
+
+namespace ib::rt {
+
+namespace {
+
+// decimal, or hexadecimal with 0x prefix
+std::optional<uint64_t> parse_u64(std::string_view str) {
+  int base = 10;
+  if (str.starts_with("0x") || str.starts_with("0X")) {
+    str.remove_prefix(2U);
+    base = 16;
+  }
+  uint64_t value = 0U;
+  auto const [ptr, ec] =
+      std::from_chars(str.data(), str.data() + str.size(), value, base);
+  if (str.empty() || ec != std::errc{} || ptr != str.data() + str.size())
+    return std::nullopt;
+  return value;
+}
+
+// register index after prefix, e.g. "v12" => 12
+std::optional<size_t> parse_index(std::string_view name, char prefix,
+                                  size_t count) {
+  if (name.size() < 2U || name.front() != prefix)
+    return std::nullopt;
+  std::optional<uint64_t> const index = parse_u64(name.substr(1U));
+  if (!index.has_value() || index.value() >= count)
+    return std::nullopt;
+  return index.value();
+}
+
+// number, or a subset of the letters "nzcv"
+std::optional<uint64_t> parse_nzcv(std::string_view str) {
+  if (std::optional<uint64_t> const value = parse_u64(str); value.has_value())
+    return value;
+  constexpr std::string_view Flags = "nzcv";
+  uint64_t value = 0U;
+  for (char c : str) {
+    size_t const bit = Flags.find(c);
+    if (bit == std::string_view::npos)
+      return std::nullopt;
+    value |= 1ULL << (31U - bit);
+  }
+  return value;
+}
+
+bool assign(InitialState &state, std::string_view name,
+            std::string_view value) {
+  if (name == "fpcr") {
+    std::optional<uint64_t> const fpcr = parse_u64(value);
+    state.fpcr_ = fpcr.value_or(0U);
+    return fpcr.has_value();
+  }
+  if (name == "nzcv") {
+    std::optional<uint64_t> const nzcv = parse_nzcv(value);
+    state.nzcv_ = nzcv.value_or(0U);
+    return nzcv.has_value();
+  }
+  if (std::optional<size_t> const index = parse_index(name, 'x', 16U);
+      index.has_value()) {
+    std::optional<uint64_t> const gpr = parse_u64(value);
+    state.gpr_[index.value()] = gpr.value_or(0U);
+    if (index.value() == 0U)
+      state.x0_scratch_ = 0U;
+    return gpr.has_value();
+  }
+  if (std::optional<size_t> const index = parse_index(name, 'v', 32U);
+      index.has_value()) {
+    size_t const colon = value.find(':');
+    std::optional<uint64_t> const low = parse_u64(value.substr(0U, colon));
+    std::optional<uint64_t> const high =
+        colon == std::string_view::npos ? 0U
+                                        : parse_u64(value.substr(colon + 1U));
+    state.vector_[index.value()][0] = low.value_or(0U);
+    state.vector_[index.value()][1] = high.value_or(0U);
+    return low.has_value() && high.has_value();
+  }
+  return false;
+}
+
+} // namespace
+
+std::optional<InitialState> parse_initial_state(std::string_view spec) {
+  InitialState state{};
+  while (!spec.empty()) {
+    size_t const comma = spec.find(',');
+    std::string_view const item = spec.substr(0U, comma);
+    spec.remove_prefix(comma == std::string_view::npos ? spec.size()
+                                                       : comma + 1U);
+    size_t const equal = item.find('=');
+    if (equal == std::string_view::npos ||
+        !assign(state, item.substr(0U, equal), item.substr(equal + 1U))) {
+      spdlog::error("invalid initial state \"{}\"", item);
+      return std::nullopt;
+    }
+  }
+  return state;
+}
+
+} // namespace ib::rt
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace ib::rt {
+
+// register and flag state each timed loop starts from, loaded by trampoline.
+// the layout is read by trampoline.s, keep the offsets below in sync.
+struct alignas(64) InitialState {
+  static constexpr size_t ScratchSize = 4096U;
+
+  // x0-x15, the rest belong to trampoline or the platform
+  uint64_t gpr_[16] = {};
+  // v0-v31, low and high 64 bits
+  uint64_t vector_[32][2] = {};
+  // default: round to nearest, no flush to zero, no default NaN
+  uint64_t fpcr_ = 0U;
+  // restored before every call, the loop counter clobbers flags
+  uint64_t nzcv_ = 0U;
+  // nonzero: x0 points to scratch_ instead of gpr_[0]
+  uint64_t x0_scratch_ = 1U;
+  // zeroed memory for snippets which load through x0
+  alignas(64) uint8_t scratch_[ScratchSize] = {};
+};
+
+static_assert(offsetof(InitialState, gpr_) == 0U);
+static_assert(offsetof(InitialState, vector_) == 128U);
+static_assert(offsetof(InitialState, fpcr_) == 640U);
+static_assert(offsetof(InitialState, nzcv_) == 648U);
+static_assert(offsetof(InitialState, x0_scratch_) == 656U);
+static_assert(offsetof(InitialState, scratch_) == 704U);
+
+// "x3=5,v0=0x3ff0000000000000:0,fpcr=0x1000000,nzcv=zc", unnamed registers
+// and flags are zero. nullopt on malformed spec
+std::optional<InitialState> parse_initial_state(std::string_view spec);
+
+} // namespace ib::rt
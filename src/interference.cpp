@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <spdlog/spdlog.h>
+#include <thread>
+#include <vector>
+
+#include "initial_state.hpp"
+#include "interference.hpp"
+#include "options.hpp"
+#include "platform.hpp"
+#include "trampoline.hpp"
+
+namespace ib::rt {
+
+namespace {
+
+constexpr size_t CacheLineSize = 64U;
+
+void alu_burst() {
+  uint64_t a0 = 1U, a1 = 2U, a2 = 3U, a3 = 4U, a4 = 5U, a5 = 6U;
+  for (size_t i = 0; i < 4096U; i++) {
+    // independent chains, the barrier keeps them from being folded
+    a0 += i, a1 += i, a2 += i, a3 += i, a4 += i, a5 += i;
+    asm volatile("" : "+r"(a0), "+r"(a1), "+r"(a2), "+r"(a3), "+r"(a4),
+                 "+r"(a5));
+  }
+}
+
+void thrash_burst(std::vector<uint8_t> &buffer) {
+  for (size_t i = 0; i < buffer.size(); i += CacheLineSize) {
+    buffer[i]++;
+    asm volatile("" : : "r"(buffer.data() + i) : "memory");
+  }
+}
+
+void stream_burst(std::vector<uint8_t> &from, std::vector<uint8_t> &to) {
+  std::memcpy(to.data(), from.data(), to.size());
+  asm volatile("" : : "r"(to.data()) : "memory");
+}
+
+} // namespace
+
+std::vector<size_t> aggressor_cpus(Placement placement, size_t victim_cpu,
+                                   size_t count) {
+  std::vector<size_t> candidates{};
+  switch (placement) {
+  case Placement::Smt:
+    candidates = platform::smt_siblings(victim_cpu);
+    break;
+  case Placement::Llc:
+    candidates = platform::llc_siblings(victim_cpu);
+    break;
+  case Placement::Remote:
+    candidates = platform::remote_node_cpus(victim_cpu);
+    break;
+  }
+  if (candidates.empty()) {
+    spdlog::warn("[interference] no cpu matches placement of cpu {}, use "
+                 "any other cpu",
+                 victim_cpu);
+    for (size_t cpu = 0; cpu < platform::cpu_count(); cpu++)
+      if (cpu != victim_cpu)
+        candidates.push_back(cpu);
+  }
+  if (candidates.empty())
+    candidates.push_back(victim_cpu);
+  if (candidates.size() < count)
+    spdlog::warn("[interference] only {} cpus for {} aggressors",
+                 candidates.size(), count);
+  std::vector<size_t> cpus{};
+  for (size_t i = 0; i < count; i++)
+    cpus.push_back(candidates[i % candidates.size()]);
+  return cpus;
+}
+
+Interference::Interference(Options const &options, size_t victim_cpu,
+                           void *aggressor_code)
+    : kind_(options.aggressor_), aggressor_code_(aggressor_code),
+      initial_state_(options.initial_state_) {
+  for (size_t cpu : aggressor_cpus(options.placement_, victim_cpu,
+                                   options.aggressor_count_)) {
+    spdlog::info("[interference] aggressor on cpu {}, victim on cpu {}", cpu,
+                 victim_cpu);
+    threads_.emplace_back([this, cpu]() { run(cpu); });
+  }
+}
+
+Interference::~Interference() {
+  stop_.store(true);
+  for (std::thread &thread : threads_)
+    thread.join();
+}
+
+void Interference::set_victim_code(void *code) { victim_code_.store(code); }
+
+void Interference::set_active(bool active) {
+  active_.store(active);
+  if (active) {
+    // give aggressors time to ramp up before the victim is measured
+    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    return;
+  }
+  victim_code_.store(nullptr);
+  // an aggressor which saw active_ before the store is counted in flight
+  while (in_flight_.load() != 0U)
+    std::this_thread::sleep_for(std::chrono::microseconds{10});
+}
+
+void Interference::run(size_t cpu) {
+  platform::pin_current_thread({cpu});
+  std::vector<uint8_t> buffer{};
+  std::vector<uint8_t> stream_buffer{};
+  switch (kind_) {
+  case AggressorKind::L1: {
+    size_t const l1d_size = platform::l1d_size(cpu);
+    buffer.resize(2U * (l1d_size == 0U ? 32U * 1024U : l1d_size));
+    break;
+  }
+  case AggressorKind::Llc: {
+    size_t const llc_size = platform::llc_size(cpu);
+    buffer.resize(2U * (llc_size == 0U ? 32U * 1024U * 1024U : llc_size));
+    break;
+  }
+  case AggressorKind::MemoryBandwidth:
+    buffer.resize(256U * 1024U * 1024U);
+    stream_buffer.resize(buffer.size());
+    break;
+  default:
+    break;
+  }
+  // each aggressor writes its own scratch memory, reset before every burst
+  InitialState state = initial_state_;
+  while (!stop_.load(std::memory_order_relaxed)) {
+    // count before checking, pairs with store then load in set_active
+    in_flight_.fetch_add(1U);
+    if (!active_.load()) {
+      in_flight_.fetch_sub(1U);
+      std::this_thread::sleep_for(std::chrono::microseconds{100});
+      continue;
+    }
+    int64_t result = 0;
+    switch (kind_) {
+    case AggressorKind::None:
+      in_flight_.fetch_sub(1U);
+      return;
+    case AggressorKind::Alu:
+      alu_burst();
+      break;
+    case AggressorKind::L1:
+    case AggressorKind::Llc:
+      thrash_burst(buffer);
+      break;
+    case AggressorKind::MemoryBandwidth:
+      stream_burst(buffer, stream_buffer);
+      break;
+    case AggressorKind::Self:
+      if (void *const code = victim_code_.load(); code != nullptr) {
+        state = initial_state_;
+        trampoline(&result, code, 1024U, &state);
+      }
+      break;
+    case AggressorKind::Snippet:
+      state = initial_state_;
+      trampoline(&result, aggressor_code_, 1024U, &state);
+      break;
+    }
+    in_flight_.fetch_sub(1U);
+  }
+}
+
+std::vector<size_t> measurement_cpus(Options const &options) {
+  std::vector<size_t> cpus = options.cpus_;
+  // executor runs on first cpu of --cpus, or cpu 0 under interference
+  size_t const victim_cpu = options.victim_cpu_.value_or(
+      options.cpus_.empty() ? 0U : options.cpus_.front());
+  cpus.push_back(victim_cpu);
+  if (options.aggressor_ != AggressorKind::None) {
+    std::vector<size_t> const aggressors = aggressor_cpus(
+        options.placement_, victim_cpu, options.aggressor_count_);
+    cpus.insert(cpus.end(), aggressors.begin(), aggressors.end());
+  }
+  return cpus;
+}
+
+} // namespace ib::rt
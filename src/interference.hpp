@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "initial_state.hpp"
+#include "options.hpp"
+
+namespace ib::rt {
+
+// pinned aggressor threads running next to the measured snippet. they idle
+// until activated so solo and loaded rounds can alternate.
+class Interference {
+  AggressorKind kind_;
+  void *aggressor_code_;
+  InitialState const &initial_state_;
+  std::atomic<void *> victim_code_{nullptr};
+  std::atomic<bool> active_{false};
+  // aggressors between checking active_ and finishing a burst
+  std::atomic<size_t> in_flight_{0U};
+  std::atomic<bool> stop_{false};
+  std::vector<std::thread> threads_;
+
+  void run(size_t cpu);
+
+public:
+  // aggressor_code is used for AggressorKind::Snippet
+  Interference(Options const &options, size_t victim_cpu,
+               void *aggressor_code);
+  ~Interference();
+  Interference(Interference const &) = delete;
+  Interference &operator=(Interference const &) = delete;
+
+  // code copied by AggressorKind::Self aggressors, set before activating
+  void set_victim_code(void *code);
+  // deactivating clears victim code and returns once every aggressor is
+  // idle, so mappings can be released afterwards
+  void set_active(bool active);
+};
+
+// cpus for aggressors by placement relative to victim. wraps around when
+// there are fewer candidates than requested.
+std::vector<size_t> aggressor_cpus(Placement placement, size_t victim_cpu,
+                                   size_t count);
+
+// victim, aggressor and --cpus cpus, helper threads keep away from them
+std::vector<size_t> measurement_cpus(Options const &options);
+
+} // namespace ib::rt
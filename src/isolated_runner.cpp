@@ -0,0 +1,176 @@
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <poll.h>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "isolated_runner.hpp"
+
+namespace ib::rt {
+
+// lives in MAP_SHARED memory, survives worker restarts
+struct IsolatedRunner::Channel {
+  void const *code_;
+  uint64_t repeat_count_;
+  int64_t result_;
+  std::atomic<int> fault_signal_;
+  void *fault_address_;
+};
+
+static IsolatedRunner::Channel *worker_channel = nullptr;
+
+static void on_fault(int signal, siginfo_t *info, void *) {
+  worker_channel->fault_address_ = info->si_addr;
+  worker_channel->fault_signal_.store(signal, std::memory_order_release);
+  _exit(128 + signal);
+}
+
+IsolatedRunner::IsolatedRunner(Kernel kernel, void *context)
+    : kernel_(kernel), context_(context) {
+  // a dead worker shows up as a failed write instead of killing us
+  std::signal(SIGPIPE, SIG_IGN);
+  void *const mem = mmap(nullptr, sizeof(Channel), PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (mem == MAP_FAILED) {
+    spdlog::error("[isolate] failed to allocate shared channel");
+    std::abort();
+  }
+  channel_ = new (mem) Channel{};
+}
+
+IsolatedRunner::~IsolatedRunner() {
+  reap(true);
+  channel_->~Channel();
+  munmap(channel_, sizeof(Channel));
+}
+
+void IsolatedRunner::spawn() {
+  channel_->fault_signal_.store(0, std::memory_order_relaxed);
+  int request_pipe[2] = {-1, -1};
+  int response_pipe[2] = {-1, -1};
+  if (pipe(request_pipe) != 0 || pipe(response_pipe) != 0) {
+    spdlog::error("[isolate] pipe failed: {}", std::strerror(errno));
+    std::abort();
+  }
+  pid_t const pid = fork();
+  if (pid < 0) {
+    spdlog::error("[isolate] fork failed: {}", std::strerror(errno));
+    std::abort();
+  }
+  if (pid > 0) {
+    close(request_pipe[0]);
+    close(response_pipe[1]);
+    pid_ = pid;
+    request_fd_ = request_pipe[1];
+    response_fd_ = response_pipe[0];
+    spdlog::info("[isolate] worker pid {} started", pid);
+    return;
+  }
+  // child, only async signal safe calls from here on
+  close(request_pipe[1]);
+  close(response_pipe[0]);
+  worker_channel = channel_;
+  struct sigaction action{};
+  action.sa_sigaction = on_fault;
+  action.sa_flags = SA_SIGINFO;
+  sigemptyset(&action.sa_mask);
+  for (int signal : {SIGSEGV, SIGILL, SIGBUS, SIGFPE, SIGTRAP})
+    sigaction(signal, &action, nullptr);
+  char byte = 0;
+  while (true) {
+    ssize_t const received = read(request_pipe[0], &byte, 1U);
+    if (received < 0 && errno == EINTR)
+      continue;
+    // parent closed its end or exited
+    if (received != 1)
+      _exit(0);
+    channel_->result_ =
+        kernel_(channel_->code_, channel_->repeat_count_, context_);
+    if (write(response_pipe[1], &byte, 1U) != 1)
+      _exit(0);
+  }
+}
+
+void IsolatedRunner::reap(bool force) {
+  if (pid_ >= 0) {
+    if (force)
+      kill(pid_, SIGKILL);
+    waitpid(pid_, nullptr, 0);
+    pid_ = -1;
+  }
+  if (request_fd_ >= 0)
+    close(request_fd_);
+  if (response_fd_ >= 0)
+    close(response_fd_);
+  request_fd_ = -1;
+  response_fd_ = -1;
+}
+
+void IsolatedRunner::restart() { reap(true); }
+
+IsolatedRunner::Result IsolatedRunner::crashed() {
+  int status = 0;
+  waitpid(pid_, &status, 0);
+  pid_ = -1;
+  reap(false);
+  int const signal = channel_->fault_signal_.load() != 0
+                         ? channel_->fault_signal_.load()
+                         : (WIFSIGNALED(status) ? WTERMSIG(status) : 0);
+  return {.status_ = Status::Crashed,
+          .value_ = 0,
+          .signal_ = signal,
+          .fault_address_ = channel_->fault_address_};
+}
+
+IsolatedRunner::Result IsolatedRunner::run(void const *code,
+                                           uint64_t repeat_count,
+                                           std::chrono::nanoseconds budget) {
+  if (pid_ < 0)
+    spawn();
+  channel_->code_ = code;
+  channel_->repeat_count_ = repeat_count;
+  char byte = 0;
+  if (write(request_fd_, &byte, 1U) != 1)
+    return crashed();
+
+  auto const deadline = std::chrono::steady_clock::now() + budget;
+  while (true) {
+    auto const remaining =
+        std::chrono::ceil<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+    if (remaining.count() <= 0) {
+      reap(true);
+      return {.status_ = Status::Timeout,
+              .value_ = 0,
+              .signal_ = 0,
+              .fault_address_ = nullptr};
+    }
+    pollfd pfd{.fd = response_fd_, .events = POLLIN, .revents = 0};
+    int const timeout_ms = static_cast<int>(std::min<int64_t>(
+        remaining.count(), std::numeric_limits<int>::max()));
+    int const ready = poll(&pfd, 1U, timeout_ms);
+    if (ready < 0 && errno == EINTR)
+      continue;
+    if (ready == 0)
+      continue;
+    // a dead worker closes its end, read returns 0
+    if (ready < 0 || read(response_fd_, &byte, 1U) != 1)
+      return crashed();
+    break;
+  }
+  return {.status_ = Status::Ok,
+          .value_ = channel_->result_,
+          .signal_ = 0,
+          .fault_address_ = nullptr};
+}
+
+} // namespace ib::rt
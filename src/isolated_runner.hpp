@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <sys/types.h>
+
+namespace ib::rt {
+
+// run a kernel in a persistent forked worker. the worker inherits every code
+// mapping alive at fork time, so restarting after a crash or after new code
+// was mapped only costs a fork. both sides block on pipes while the other
+// runs, neither spins on the measured cpu.
+class IsolatedRunner {
+public:
+  using Kernel = int64_t (*)(void const *code, uint64_t repeat_count,
+                             void *context);
+
+  enum class Status { Ok, Crashed, Timeout };
+
+  struct Result {
+    Status status_;
+    int64_t value_;
+    int signal_;
+    void *fault_address_;
+  };
+
+  struct Channel;
+
+private:
+  Kernel kernel_;
+  // passed to kernel, the worker sees a copy as of fork time
+  void *context_;
+  Channel *channel_;
+  pid_t pid_ = -1;
+  // parent ends, a byte per request and per response
+  int request_fd_ = -1;
+  int response_fd_ = -1;
+
+  void spawn();
+  void reap(bool force);
+  // collect a worker which exited while running a request
+  Result crashed();
+
+public:
+  IsolatedRunner(Kernel kernel, void *context);
+  ~IsolatedRunner();
+  IsolatedRunner(IsolatedRunner const &) = delete;
+  IsolatedRunner &operator=(IsolatedRunner const &) = delete;
+
+  // drop current worker, next run forks one seeing all current mappings
+  void restart();
+
+  Result run(void const *code, uint64_t repeat_count,
+             std::chrono::nanoseconds budget);
+};
+
+} // namespace ib::rt
@@ -31,6 +31,7 @@
 #include "llvm/Target/TargetOptions.h"
 #include "llvm/TargetParser/Host.h"
 #include "machine_code.hpp"
+#include "trace.hpp"
 
 using namespace llvm;
 
@@ -94,6 +95,7 @@ void ib::llvm::init() {
 }
 
 std::unique_ptr<ib::MachineCode> ib::llvm::compile(const std::string &asmStr) {
+  IB_TRACE_SPAN("compile");
   const Target *target = getTarget();
   Triple triple{sys::getDefaultTargetTriple()};
 
@@ -159,6 +161,11 @@ std::unique_ptr<ib::MachineCode> ib::llvm::compile(const std::string &asmStr) {
   MCInst inst;
 
   int Res = asm_parser->Run(true);
+  if (Res != 0) {
+    // diagnostics already went through source manager
+    spdlog::error("failed to assemble snippet");
+    return nullptr;
+  }
 
   std::unique_ptr<ib::MachineCode> ret{new ib::MachineCode()};
   ret->resize(ib_streamer->code_.size());
@@ -166,3 +173,16 @@ std::unique_ptr<ib::MachineCode> ib::llvm::compile(const std::string &asmStr) {
               ib_streamer->code_.size());
   return ret;
 }
+
+std::unique_ptr<ib::MachineCode>
+ib::llvm::compile_snippet(const std::string &asmStr) {
+  static std::string const asm_prefix = R"(
+	.section	__TEXT,__text,regular,pure_instructions
+	.global	main
+main:
+  )";
+  static std::string const asm_postfix = R"(
+  ret
+  )";
+  return compile(asm_prefix + asmStr + asm_postfix);
+}
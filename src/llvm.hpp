@@ -8,6 +8,10 @@ namespace ib::llvm {
 
 void init();
 
+// nullptr when the assembly does not parse
 std::unique_ptr<ib::MachineCode> compile(const std::string &asmStr);
 
+// wrap a snippet into a callable function and compile it
+std::unique_ptr<ib::MachineCode> compile_snippet(const std::string &asmStr);
+
 } // namespace ib::llvm
@@ -1,77 +1,127 @@
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
 #include <llvm/Support/TargetSelect.h>
+#include <cstdlib>
 #include <memory>
+#include <optional>
 #include <spdlog/cfg/env.h>
 #include <spdlog/spdlog.h>
+#include <string>
 #include <thread>
 
+#include "bootstrap.hpp"
+#include "campaign.hpp"
+#include "case_registry.hpp"
+#include "daemon.hpp"
 #include "executor.hpp"
+#include "interference.hpp"
 #include "llvm.hpp"
 #include "machine_code.hpp"
+#include "options.hpp"
+#include "platform.hpp"
+#include "reporter.hpp"
+#include "snapshot.hpp"
 #include "statistic.hpp"
+#include "suite.hpp"
+#include "trace.hpp"
 #include "uuid.hpp"
 
-void add_bench_target(
-    ib::UUID uuid, std::string const &asm_str,
-    MultipleThreadQueue<ib::MachineCode> &machine_code_queue) {
-  static std::string const asm_prefix = R"(
-	.section	__TEXT,__text,regular,pure_instructions
-	.global	main
-main:
-  )";
-  static std::string const asm_postfix = R"(
-  ret
-  )";
-  std::unique_ptr<ib::MachineCode> machine_code =
-      ib::llvm::compile(asm_prefix + asm_str + asm_postfix);
-  machine_code->uuid_ = uuid;
-  spdlog::info("machine code for \"{}\":\n{}", asm_str, *machine_code);
-  machine_code_queue.push(std::move(machine_code));
+static int merge_snapshots(ib::Options const &options) {
+  ib::rt::Snapshot merged{};
+  for (std::string const &input : options.merge_inputs_) {
+    std::optional<ib::rt::Snapshot> snapshot = ib::rt::read_snapshot(input);
+    if (!snapshot.has_value())
+      return EXIT_FAILURE;
+    ib::rt::merge_snapshot(merged, snapshot.value());
+  }
+  ib::rt::log_snapshot(merged);
+  return ib::rt::write_snapshot(options.merge_output_.value(), merged)
+             ? EXIT_SUCCESS
+             : EXIT_FAILURE;
 }
 
-void add_bench_target(
-    std::string const &asm_str,
-    MultipleThreadQueue<ib::MachineCode> &machine_code_queue) {
-  add_bench_target(ib::UUIDUtils::alloc(), asm_str, machine_code_queue);
-}
+int main(int argc, char **argv) {
+  spdlog::cfg::load_env_levels();
+  ib::Options const options = ib::parse_options(argc, argv);
+  if (options.merge_output_.has_value())
+    return merge_snapshots(options);
+  if (options.shard_count_ > 0U)
+    return ib::run_campaign(options, argc, argv);
+  if (!options.cpus_.empty())
+    ib::platform::pin_current_thread(options.cpus_);
 
-int main() {
+  if (options.trace_path_.has_value() && !ib::trace::enabled)
+    spdlog::warn("tracing is compiled out, configure with "
+                 "-DINSTR_BENCH_TRACE=ON");
+  ib::trace::set_thread_name("main");
   ib::llvm::init();
-  spdlog::cfg::load_env_levels();
 
   MultipleThreadQueue<ib::MachineCode> machine_code_queue;
   MultipleThreadQueue<ib::UUID> cancel_queue;
   MultipleThreadQueue<ib::rt::Sample> statistic_queue;
+  ib::rt::BootstrapWorker bootstrap_worker;
+  ib::CaseRegistry case_registry;
+  ib::Suite suite{machine_code_queue, cancel_queue, options, case_registry};
+  ib::rt::ReportBuffer report_buffer;
 
   std::thread execute_thread{[&]() {
+    ib::trace::set_thread_name("executor");
     ib::rt::Executor executor{machine_code_queue, cancel_queue,
-                              statistic_queue};
+                              statistic_queue, options};
     executor.start();
   }};
 
   std::thread statistic_thread{[&]() {
-    ib::rt::Statistic statistic{statistic_queue};
+    ib::trace::set_thread_name("statistic");
+    ib::rt::Statistic statistic{statistic_queue, bootstrap_worker,
+                                report_buffer, options};
     statistic.start();
   }};
 
-  // custom
-  add_bench_target(R"(
+  std::thread reporter_thread{[&]() {
+    ib::trace::set_thread_name("reporter");
+    ib::rt::Reporter reporter{report_buffer, bootstrap_worker, options,
+                              case_registry};
+    reporter.start();
+  }};
+
+  std::thread bootstrap_thread{[&]() {
+    ib::trace::set_thread_name("bootstrap");
+    bootstrap_worker.start(
+        ib::platform::housekeeping_cpus(ib::rt::measurement_cpus(options)));
+  }};
+
+  // custom, a daemon starts empty and gets its cases from clients
+  if (!options.daemon_socket_.has_value()) {
+    suite.add_target(R"(
     mov x8, x0
     add x8, x8, #128
     ldr x1, [x8]
-  )",
-                   machine_code_queue);
-  add_bench_target(R"(
+  )");
+    suite.add_target(R"(
     add x8, x0, #128
     ldr x1, [x8]
-  )",
-                   machine_code_queue);
+  )");
+  }
+  for (size_t i = 0; i < options.templates_.size(); i++) {
+    if (!suite.add_template("template" + std::to_string(i),
+                            options.templates_[i]))
+      std::exit(EXIT_FAILURE);
+  }
+
+  // more shards than cases, the executor idles on the control group
+  if (options.shard_.has_value() && case_registry.uuids().empty())
+    spdlog::warn("shard {} has no cases", options.shard_->index_);
 
   // send control group, start execute
-  add_bench_target(ib::UUIDUtils::control_group_uuid, R"()",
-                   machine_code_queue);
+  suite.add_target(ib::UUIDUtils::control_group_uuid, R"()");
+  if (options.daemon_socket_.has_value()) {
+    ib::Daemon daemon{options, suite, report_buffer, case_registry};
+    daemon.start();
+  }
   execute_thread.join();
   statistic_thread.join();
+  reporter_thread.join();
+  bootstrap_thread.join();
   return 0;
 }
@@ -0,0 +1,50 @@
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "machine_code.hpp"
+#include "mmap_raii.hpp"
+#include "trace.hpp"
+
+static size_t get_page_size() {
+  static size_t const page_size = static_cast<size_t>(sysconf(_SC_PAGE_SIZE));
+  return page_size;
+}
+
+static size_t round_to_page_size(size_t size) {
+  size_t const page_size = get_page_size();
+  return (size + page_size - 1) & ~(page_size - 1);
+}
+
+namespace ib::rt {
+
+MMapRAII::MMapRAII(MachineCode const &machine_code) : exec_mem_(nullptr) {
+  IB_TRACE_SPAN("mmap");
+  code_size_ = round_to_page_size(machine_code.size());
+  spdlog::info("[mm] mmap code with RW permission");
+  exec_mem_ = mmap(nullptr, code_size_, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (exec_mem_ == MAP_FAILED) {
+    spdlog::error("[mm] failed to allocate executable memory");
+    std::abort();
+  }
+  spdlog::info("[mm] mmaped with RW permission in [{} {}]", exec_mem_,
+               code_size_);
+  std::memcpy(exec_mem_, machine_code.data(), machine_code.size());
+  spdlog::info("[mm] mprotect with RE permission in [{} {}]", exec_mem_,
+               code_size_);
+  mprotect(exec_mem_, code_size_, PROT_READ | PROT_EXEC);
+}
+
+MMapRAII::~MMapRAII() {
+  IB_TRACE_SPAN("munmap");
+  if (exec_mem_ != MAP_FAILED) {
+    spdlog::info("[mm] munmap [{} {}]", exec_mem_, code_size_);
+    munmap(exec_mem_, code_size_);
+  }
+}
+
+} // namespace ib::rt
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+
+#include "machine_code.hpp"
+
+namespace ib::rt {
+
+// copy machine code into its own pages and make them executable
+class MMapRAII {
+  void *exec_mem_;
+  size_t code_size_;
+
+public:
+  void *get_exec_mem() const { return exec_mem_; }
+
+  explicit MMapRAII(MachineCode const &machine_code);
+  ~MMapRAII();
+  MMapRAII(MMapRAII const &) = delete;
+  MMapRAII &operator=(MMapRAII const &) = delete;
+};
+
+} // namespace ib::rt
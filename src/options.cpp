@@ -0,0 +1,184 @@
+#include <charconv>
+#include <cstdlib>
+#include <optional>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <string_view>
+
+#include "initial_state.hpp"
+#include "options.hpp"
+#include "platform.hpp"
+
+namespace ib {
+
+static void print_usage(char const *program) {
+  spdlog::info("usage: {} [options]\n"
+               "  --snapshot <path>               write statistics snapshot "
+               "periodically\n"
+               "  --resume <path>                 continue from a snapshot\n"
+               "  --merge <output> <input>...     merge snapshots and exit\n"
+               "  --shards <n>                    run suite in n worker "
+               "processes\n"
+               "  --shard <i>/<n>                 only run cases of shard i\n"
+               "  --report-socket <path>          stream partials to "
+               "coordinator\n"
+               "  --cpus <list>                   pin to cpus, e.g. 0,2,4-7\n"
+               "  --isolate                       run snippets in a forked "
+               "worker\n"
+               "  --watchdog-cycles <n>           cycle budget per iteration "
+               "in isolated worker\n"
+               "  --aggressor <kind>              alu, l1, llc, membw or self, "
+               "self not with --isolate\n"
+               "  --aggressor-asm <asm>           run snippet as aggressor\n"
+               "  --placement <where>             smt, llc or remote\n"
+               "  --aggressor-count <n>           number of aggressor threads\n"
+               "  --victim-cpu <cpu>              pin measurement to cpu\n"
+               "  --template <template>           add cases from snippet "
+               "template\n"
+               "  --trace <path>                  dump pipeline spans as "
+               "chrome trace\n"
+               "  --daemon <path>                 accept cases over unix "
+               "socket\n"
+               "  --report <path>                 rewrite report file instead "
+               "of drawing\n"
+               "  --init <spec>                   initial state, e.g. "
+               "x1=0x10,v0=1:0,fpcr=0x1000000,nzcv=zc",
+               program);
+}
+
+static std::optional<size_t> parse_size(std::string_view str) {
+  size_t value = 0U;
+  auto const [ptr, ec] =
+      std::from_chars(str.data(), str.data() + str.size(), value);
+  if (ec != std::errc{} || ptr != str.data() + str.size())
+    return std::nullopt;
+  return value;
+}
+
+Options parse_options(int argc, char **argv) {
+  Options options{};
+  auto const fail = [&](std::string_view message, std::string_view value) {
+    spdlog::error("{} {}", message, value);
+    print_usage(argv[0]);
+    std::exit(EXIT_FAILURE);
+  };
+  auto const next_value = [&](int &i) -> std::string {
+    if (i + 1 >= argc)
+      fail("missing value for", argv[i]);
+    return argv[++i];
+  };
+  for (int i = 1; i < argc; i++) {
+    std::string_view const arg = argv[i];
+    if (arg == "--snapshot") {
+      options.snapshot_path_ = next_value(i);
+    } else if (arg == "--resume") {
+      options.resume_path_ = next_value(i);
+    } else if (arg == "--merge") {
+      options.merge_output_ = next_value(i);
+      while (i + 1 < argc)
+        options.merge_inputs_.emplace_back(argv[++i]);
+    } else if (arg == "--shards") {
+      std::string const value = next_value(i);
+      std::optional<size_t> const count = parse_size(value);
+      if (!count.has_value() || count.value() == 0U)
+        fail("invalid shard count", value);
+      options.shard_count_ = count.value();
+    } else if (arg == "--shard") {
+      std::string const value = next_value(i);
+      size_t const slash = value.find('/');
+      std::optional<size_t> const index =
+          parse_size(std::string_view{value}.substr(0, slash));
+      std::optional<size_t> const count =
+          slash == std::string::npos
+              ? std::nullopt
+              : parse_size(std::string_view{value}.substr(slash + 1));
+      if (!index.has_value() || !count.has_value() ||
+          index.value() >= count.value())
+        fail("invalid shard", value);
+      options.shard_ = Shard{.index_ = index.value(), .count_ = count.value()};
+    } else if (arg == "--report-socket") {
+      options.report_socket_ = next_value(i);
+    } else if (arg == "--cpus") {
+      std::string const value = next_value(i);
+      std::optional<std::vector<size_t>> cpus =
+          platform::parse_cpu_list(value);
+      if (!cpus.has_value() || cpus->empty())
+        fail("invalid cpu list", value);
+      options.cpus_ = std::move(cpus.value());
+    } else if (arg == "--isolate") {
+      options.isolate_ = true;
+    } else if (arg == "--watchdog-cycles") {
+      std::string const value = next_value(i);
+      std::optional<size_t> const cycles = parse_size(value);
+      if (!cycles.has_value() || cycles.value() == 0U)
+        fail("invalid watchdog cycles", value);
+      options.watchdog_cycles_ = cycles.value();
+    } else if (arg == "--aggressor") {
+      std::string const value = next_value(i);
+      if (value == "alu")
+        options.aggressor_ = AggressorKind::Alu;
+      else if (value == "l1")
+        options.aggressor_ = AggressorKind::L1;
+      else if (value == "llc")
+        options.aggressor_ = AggressorKind::Llc;
+      else if (value == "membw")
+        options.aggressor_ = AggressorKind::MemoryBandwidth;
+      else if (value == "self")
+        options.aggressor_ = AggressorKind::Self;
+      else
+        fail("invalid aggressor", value);
+    } else if (arg == "--aggressor-asm") {
+      options.aggressor_ = AggressorKind::Snippet;
+      options.aggressor_asm_ = next_value(i);
+    } else if (arg == "--placement") {
+      std::string const value = next_value(i);
+      if (value == "smt")
+        options.placement_ = Placement::Smt;
+      else if (value == "llc")
+        options.placement_ = Placement::Llc;
+      else if (value == "remote")
+        options.placement_ = Placement::Remote;
+      else
+        fail("invalid placement", value);
+    } else if (arg == "--aggressor-count") {
+      std::string const value = next_value(i);
+      std::optional<size_t> const count = parse_size(value);
+      if (!count.has_value() || count.value() == 0U)
+        fail("invalid aggressor count", value);
+      options.aggressor_count_ = count.value();
+    } else if (arg == "--victim-cpu") {
+      std::string const value = next_value(i);
+      options.victim_cpu_ = parse_size(value);
+      if (!options.victim_cpu_.has_value())
+        fail("invalid victim cpu", value);
+    } else if (arg == "--template") {
+      options.templates_.push_back(next_value(i));
+    } else if (arg == "--trace") {
+      options.trace_path_ = next_value(i);
+    } else if (arg == "--daemon") {
+      options.daemon_socket_ = next_value(i);
+    } else if (arg == "--report") {
+      options.report_path_ = next_value(i);
+    } else if (arg == "--init") {
+      std::string const value = next_value(i);
+      std::optional<rt::InitialState> const state =
+          rt::parse_initial_state(value);
+      if (!state.has_value())
+        fail("invalid initial state", value);
+      options.initial_state_ = state.value();
+    } else if (arg == "--help" || arg == "-h") {
+      print_usage(argv[0]);
+      std::exit(EXIT_SUCCESS);
+    } else {
+      fail("unknown option", arg);
+    }
+  }
+  if (options.daemon_socket_.has_value() && options.shard_count_ > 0U)
+    fail("--daemon can not be combined with", "--shards");
+  // self aggressors run the victim in this process, outside the worker
+  if (options.isolate_ && options.aggressor_ == AggressorKind::Self)
+    fail("--isolate can not be combined with", "--aggressor self");
+  return options;
+}
+
+} // namespace ib
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "initial_state.hpp"
+
+namespace ib {
+
+struct Shard {
+  size_t index_;
+  size_t count_;
+};
+
+enum class AggressorKind {
+  None,
+  // saturate integer ALU ports
+  Alu,
+  // thrash L1 data cache
+  L1,
+  // thrash last level cache
+  Llc,
+  // stream memory bandwidth
+  MemoryBandwidth,
+  // copies of the snippet being measured
+  Self,
+  // user snippet from aggressor_asm_
+  Snippet,
+};
+
+enum class Placement { Smt, Llc, Remote };
+
+struct Options {
+  // periodically write accumulated statistics to this path
+  std::optional<std::string> snapshot_path_;
+  // load accumulated statistics before measuring
+  std::optional<std::string> resume_path_;
+  // offline merge of snapshots, no measurement
+  std::optional<std::string> merge_output_;
+  std::vector<std::string> merge_inputs_;
+  // coordinator, split suite into shards run by worker processes
+  size_t shard_count_ = 0U;
+  // worker, only run cases of this shard and stream partials to socket
+  std::optional<Shard> shard_;
+  std::optional<std::string> report_socket_;
+  std::vector<size_t> cpus_;
+  // run snippets in a forked worker, quarantine crashing or hanging cases
+  bool isolate_ = false;
+  uint64_t watchdog_cycles_ = 1000000U;
+  // co-runner interference, measured rounds alternate solo and loaded
+  AggressorKind aggressor_ = AggressorKind::None;
+  std::string aggressor_asm_;
+  Placement placement_ = Placement::Smt;
+  size_t aggressor_count_ = 1U;
+  std::optional<size_t> victim_cpu_;
+  // snippet templates, see AsmTemplate
+  std::vector<std::string> templates_;
+  // chrome trace json of pipeline spans, needs INSTR_BENCH_TRACE build
+  std::optional<std::string> trace_path_;
+  // keep running and accept cases over this unix socket
+  std::optional<std::string> daemon_socket_;
+  // rewrite this file with the report instead of drawing to the terminal
+  std::optional<std::string> report_path_;
+  // registers and flags every timed loop starts from
+  rt::InitialState initial_state_{};
+};
+
+Options parse_options(int argc, char **argv);
+
+} // namespace ib
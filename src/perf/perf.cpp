@@ -0,0 +1,219 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fmt/format.h>
+#include <functional>
+#include <memory>
+#include <spdlog/cfg/env.h>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "bootstrap.hpp"
+#include "llvm.hpp"
+#include "machine_code.hpp"
+#include "mmap_raii.hpp"
+#include "multiple_thread_queue.hpp"
+#include "options.hpp"
+#include "platform.hpp"
+#include "statistic.hpp"
+#include "tdigest.hpp"
+#include "trampoline.hpp"
+
+// microbenchmarks of the harness hot paths, one JSON object per line:
+//   {"name": "...", "param": n, "iterations": n, "value": x, "unit": "..."}
+
+namespace {
+
+class Reporter {
+  FILE *out_;
+
+public:
+  explicit Reporter(FILE *out) : out_(out) {}
+
+  void report(std::string_view name, uint64_t param, uint64_t iterations,
+              double_t value, std::string_view unit) {
+    // json has no inf or nan
+    std::string const json_value =
+        std::isfinite(value) ? fmt::format("{}", value) : "null";
+    std::string const line = fmt::format(
+        "{{\"name\": \"{}\", \"param\": {}, \"iterations\": {}, "
+        "\"value\": {}, \"unit\": \"{}\"}}\n",
+        name, param, iterations, json_value, unit);
+    std::fputs(line.c_str(), out_);
+    std::fflush(out_);
+  }
+};
+
+// ns per call of fn
+double_t time_per_call(uint64_t iterations, std::function<void()> const &fn) {
+  auto const start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < iterations; i++)
+    fn();
+  auto const end = std::chrono::steady_clock::now();
+  return static_cast<double_t>(
+             std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+                 .count()) /
+         static_cast<double_t>(iterations);
+}
+
+// lcg spread continuously over [100, 1100), like cycle counts of a case.
+// few distinct values would collapse the digest into a handful of
+// centroids and flatter it
+class CycleSource {
+  uint64_t state_ = 1U;
+
+public:
+  double_t next() {
+    state_ = state_ * 6364136223846793005ULL + 1442695040888963407ULL;
+    return 100.0 + 1000.0 * (static_cast<double_t>(state_) * 0x1p-64);
+  }
+};
+
+std::string snippet(size_t i) {
+  return fmt::format("add x{}, x{}, #{}\nldr x1, [x0]\n", i % 8U, (i + 1) % 8U,
+                     i % 4096U);
+}
+
+void bench_compile(Reporter &reporter) {
+  constexpr uint64_t Iterations = 200U;
+  double_t const per_snippet = time_per_call(
+      Iterations, []() { ib::llvm::compile_snippet(snippet(0U)); });
+  reporter.report("llvm_compile_snippet", 1U, Iterations, per_snippet, "ns");
+
+  for (size_t batch : {10U, 100U}) {
+    double_t const per_batch = time_per_call(10U, [batch]() {
+      for (size_t i = 0; i < batch; i++)
+        ib::llvm::compile_snippet(snippet(i));
+    });
+    reporter.report("llvm_compile_batch", batch, 10U, per_batch, "ns");
+  }
+}
+
+void bench_queue(Reporter &reporter) {
+  constexpr uint64_t ItemsPerProducer = 200000U;
+  for (size_t producers : {1U, 2U, 4U, 8U}) {
+    MultipleThreadQueue<uint64_t> queue;
+    uint64_t const total = ItemsPerProducer * producers;
+    auto const start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads{};
+    for (size_t p = 0; p < producers; p++) {
+      threads.emplace_back([&queue]() {
+        for (uint64_t i = 0; i < ItemsPerProducer; i++)
+          queue.push(std::make_unique<uint64_t>(i));
+      });
+    }
+    uint64_t consumed = 0U;
+    while (consumed < total) {
+      queue.pop();
+      consumed++;
+    }
+    for (std::thread &thread : threads)
+      thread.join();
+    double_t const seconds = std::chrono::duration<double_t>(
+                                 std::chrono::steady_clock::now() - start)
+                                 .count();
+    reporter.report("queue_push_pop", producers, total,
+                    static_cast<double_t>(total) / seconds, "items/s");
+  }
+}
+
+void bench_tdigest(Reporter &reporter) {
+  for (uint64_t count : {1000U, 10000U, 100000U}) {
+    ib::rt::TDigest tdigest{};
+    CycleSource source{};
+    double_t const add =
+        time_per_call(count, [&]() { tdigest.add(source.next()); });
+    reporter.report("tdigest_add", count, count, add, "ns");
+    double_t const quantile =
+        time_per_call(1000U, [&]() { (void)tdigest.quantile(0.5); });
+    reporter.report("tdigest_quantile", count, 1000U, quantile, "ns");
+  }
+}
+
+void bench_mmap(Reporter &reporter) {
+  constexpr uint64_t Iterations = 1000U;
+  std::unique_ptr<ib::MachineCode> const code =
+      ib::llvm::compile_snippet(snippet(0U));
+  double_t const per_mapping = time_per_call(
+      Iterations, [&]() { ib::rt::MMapRAII const mmap_raii{*code}; });
+  reporter.report("mmap_raii_setup_teardown", 1U, Iterations, per_mapping,
+                  "ns");
+}
+
+void bench_trampoline(Reporter &reporter) {
+  std::unique_ptr<ib::MachineCode> const code =
+      ib::llvm::compile_snippet("");
+  ib::rt::MMapRAII const mmap_raii{*code};
+  double_t const ns_per_tick =
+      1e9 / static_cast<double_t>(ib::platform::timer_frequency());
+  ib::rt::InitialState state{};
+  for (uint64_t repeat_count : {1U << 10, 1U << 16}) {
+    int64_t ticks = 0;
+    trampoline(&ticks, mmap_raii.get_exec_mem(), repeat_count, &state);
+    trampoline(&ticks, mmap_raii.get_exec_mem(), repeat_count, &state);
+    double_t const per_iteration =
+        static_cast<double_t>(ticks) / static_cast<double_t>(repeat_count);
+    reporter.report("trampoline_floor", repeat_count, repeat_count,
+                    per_iteration * ns_per_tick, "ns");
+  }
+}
+
+void bench_statistic(Reporter &reporter) {
+  constexpr uint64_t Iterations = 100000U;
+  for (uint64_t case_count : {1U, 16U, 256U}) {
+    MultipleThreadQueue<ib::rt::Sample> queue;
+    ib::rt::BootstrapWorker bootstrap_worker{};
+    ib::Options const options{};
+    ib::rt::ReportBuffer report_buffer{};
+    ib::rt::Statistic statistic{queue, bootstrap_worker, report_buffer,
+                                options};
+    CycleSource source{};
+    uint64_t i = 0U;
+    double_t const per_sample = time_per_call(Iterations, [&]() {
+      // 3.2 GHz core, 24 MHz timer
+      double_t const cycles = source.next();
+      statistic.update(ib::rt::Sample{
+          .uuid_ = i % case_count,
+          .cpu_cycle_ = cycles,
+          .ticks_ = cycles * (24.0 / 3200.0),
+          .nanoseconds_ = cycles / 3.2,
+          .frequency_changed_ = false,
+          .loaded_ = false});
+      i++;
+    });
+    reporter.report("statistic_update", case_count, Iterations, per_sample,
+                    "ns");
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  spdlog::cfg::load_env_levels();
+  // keep mmap and compile logging out of the numbers
+  spdlog::set_level(spdlog::level::warn);
+  FILE *out = stdout;
+  if (argc > 1) {
+    out = std::fopen(argv[1], "w");
+    if (out == nullptr) {
+      spdlog::error("failed to open {}", argv[1]);
+      return EXIT_FAILURE;
+    }
+  }
+  ib::llvm::init();
+  Reporter reporter{out};
+  bench_compile(reporter);
+  bench_queue(reporter);
+  bench_tdigest(reporter);
+  bench_mmap(reporter);
+  bench_trampoline(reporter);
+  bench_statistic(reporter);
+  if (out != stdout)
+    std::fclose(out);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,259 @@
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <string_view>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <sys/sysctl.h>
+#endif
+
+#include "platform.hpp"
+
+namespace ib::platform {
+
+std::optional<std::vector<size_t>> parse_cpu_list(std::string_view list) {
+  std::vector<size_t> cpus{};
+  auto const parse_number = [](std::string_view str) -> std::optional<size_t> {
+    size_t value = 0U;
+    auto const [ptr, ec] =
+        std::from_chars(str.data(), str.data() + str.size(), value);
+    if (ec != std::errc{} || ptr != str.data() + str.size())
+      return std::nullopt;
+    return value;
+  };
+  while (!list.empty()) {
+    size_t const comma = list.find(',');
+    std::string_view const item = list.substr(0, comma);
+    list = comma == std::string_view::npos ? std::string_view{}
+                                           : list.substr(comma + 1);
+    size_t const dash = item.find('-');
+    std::optional<size_t> const first = parse_number(item.substr(0, dash));
+    std::optional<size_t> const last =
+        dash == std::string_view::npos ? first
+                                       : parse_number(item.substr(dash + 1));
+    if (!first.has_value() || !last.has_value() || *first > *last)
+      return std::nullopt;
+    for (size_t cpu = *first; cpu <= *last; cpu++)
+      cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+std::string format_cpu_list(std::vector<size_t> const &cpus) {
+  std::string list{};
+  for (size_t cpu : cpus) {
+    if (!list.empty())
+      list += ",";
+    list += std::to_string(cpu);
+  }
+  return list;
+}
+
+size_t cpu_count() {
+  unsigned const count = std::thread::hardware_concurrency();
+  return count == 0U ? 1U : count;
+}
+
+std::vector<std::vector<size_t>> numa_nodes() {
+  std::vector<std::vector<size_t>> nodes{};
+#if defined(__linux__)
+  for (size_t node = 0;; node++) {
+    std::ifstream in{"/sys/devices/system/node/node" + std::to_string(node) +
+                     "/cpulist"};
+    std::string line{};
+    if (!in || !std::getline(in, line))
+      break;
+    std::optional<std::vector<size_t>> cpus = parse_cpu_list(line);
+    if (cpus.has_value() && !cpus->empty())
+      nodes.push_back(std::move(cpus.value()));
+  }
+#endif
+  if (nodes.empty()) {
+    std::vector<size_t> all{};
+    for (size_t cpu = 0; cpu < cpu_count(); cpu++)
+      all.push_back(cpu);
+    nodes.push_back(std::move(all));
+  }
+  return nodes;
+}
+
+static std::optional<std::string> read_line(std::string const &path) {
+  std::ifstream in{path};
+  std::string line{};
+  if (!in || !std::getline(in, line))
+    return std::nullopt;
+  return line;
+}
+
+static std::vector<size_t> read_cpu_list(std::string const &path) {
+  std::optional<std::string> const line = read_line(path);
+  if (!line.has_value())
+    return {};
+  return parse_cpu_list(line.value()).value_or(std::vector<size_t>{});
+}
+
+static std::string cpu_path(size_t cpu) {
+  return "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+}
+
+// cache index with the highest level
+static std::optional<std::string> llc_path(size_t cpu) {
+  std::optional<std::string> path{};
+  size_t max_level = 0U;
+  for (size_t index = 0;; index++) {
+    std::string const index_path =
+        cpu_path(cpu) + "/cache/index" + std::to_string(index);
+    std::optional<std::string> const level = read_line(index_path + "/level");
+    if (!level.has_value())
+      break;
+    size_t const value = std::strtoul(level->c_str(), nullptr, 10);
+    if (value > max_level) {
+      max_level = value;
+      path = index_path;
+    }
+  }
+  return path;
+}
+
+static std::vector<size_t> remove_cpus(std::vector<size_t> cpus,
+                                       std::vector<size_t> const &removed) {
+  std::erase_if(cpus, [&](size_t cpu) {
+    return std::find(removed.begin(), removed.end(), cpu) != removed.end();
+  });
+  return cpus;
+}
+
+std::vector<size_t> smt_siblings(size_t cpu) {
+  return remove_cpus(
+      read_cpu_list(cpu_path(cpu) + "/topology/thread_siblings_list"), {cpu});
+}
+
+std::vector<size_t> llc_siblings(size_t cpu) {
+  std::optional<std::string> const path = llc_path(cpu);
+  if (!path.has_value())
+    return {};
+  std::vector<size_t> removed = smt_siblings(cpu);
+  removed.push_back(cpu);
+  return remove_cpus(read_cpu_list(path.value() + "/shared_cpu_list"),
+                     removed);
+}
+
+std::vector<size_t> remote_node_cpus(size_t cpu) {
+  std::vector<size_t> cpus{};
+  for (std::vector<size_t> const &node : numa_nodes()) {
+    if (std::find(node.begin(), node.end(), cpu) == node.end())
+      cpus.insert(cpus.end(), node.begin(), node.end());
+  }
+  return cpus;
+}
+
+static size_t cache_size(std::string const &index_path) {
+  std::optional<std::string> const size = read_line(index_path + "/size");
+  if (!size.has_value())
+    return 0U;
+  // e.g. "32768K"
+  size_t value = std::strtoul(size->c_str(), nullptr, 10);
+  if (size->ends_with('K'))
+    value *= 1024U;
+  else if (size->ends_with('M'))
+    value *= 1024U * 1024U;
+  return value;
+}
+
+size_t llc_size(size_t cpu) {
+  std::optional<std::string> const path = llc_path(cpu);
+  return path.has_value() ? cache_size(path.value()) : 0U;
+}
+
+size_t l1d_size([[maybe_unused]] size_t cpu) {
+#if defined(__APPLE__)
+  // no per cpu value, the performance cores have the larger cache
+  uint64_t value = 0U;
+  size_t length = sizeof(value);
+  if (sysctlbyname("hw.perflevel0.l1dcachesize", &value, &length, nullptr,
+                   0U) != 0 &&
+      sysctlbyname("hw.l1dcachesize", &value, &length, nullptr, 0U) != 0)
+    return 0U;
+  return static_cast<size_t>(value);
+#else
+  for (size_t index = 0;; index++) {
+    std::string const index_path =
+        cpu_path(cpu) + "/cache/index" + std::to_string(index);
+    std::optional<std::string> const level = read_line(index_path + "/level");
+    if (!level.has_value())
+      return 0U;
+    if (level.value() == "1" && read_line(index_path + "/type") == "Data")
+      return cache_size(index_path);
+  }
+#endif
+}
+
+bool pin_current_thread(std::vector<size_t> const &cpus) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (size_t cpu : cpus)
+    CPU_SET(cpu, &set);
+  int const ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (ret != 0) {
+    spdlog::warn("[platform] failed to pin thread to {}: {}",
+                 format_cpu_list(cpus), ret);
+    return false;
+  }
+  spdlog::info("[platform] pinned thread to {}", format_cpu_list(cpus));
+  return true;
+#else
+  spdlog::warn("[platform] thread pinning is not supported, ignore {}",
+               format_cpu_list(cpus));
+  return false;
+#endif
+}
+
+std::vector<size_t> housekeeping_cpus(std::vector<size_t> const &busy) {
+  std::vector<size_t> cpus{};
+  for (size_t cpu = cpu_count(); cpu-- > 0U;) {
+    if (std::find(busy.begin(), busy.end(), cpu) == busy.end())
+      cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+bool lower_current_thread_priority() {
+#if defined(__linux__)
+  // nice value is per thread on linux
+  int const ret = setpriority(PRIO_PROCESS, gettid(), 19);
+#elif defined(__APPLE__)
+  int const ret = setpriority(PRIO_DARWIN_THREAD, 0, PRIO_DARWIN_BG);
+#else
+  int const ret = -1;
+#endif
+  if (ret != 0) {
+    spdlog::warn("[platform] failed to lower thread priority");
+    return false;
+  }
+  return true;
+}
+
+uint64_t timer_frequency() {
+#if defined(__aarch64__)
+  uint64_t value = 0U;
+  asm volatile("mrs %0, cntfrq_el0" : "=r"(value));
+  return value;
+#else
+  return 1000000000U;
+#endif
+}
+
+} // namespace ib::platform
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ib::platform {
+
+// "0,2,4-7" => {0, 2, 4, 5, 6, 7}
+std::optional<std::vector<size_t>> parse_cpu_list(std::string_view list);
+std::string format_cpu_list(std::vector<size_t> const &cpus);
+
+size_t cpu_count();
+
+// cpus of each NUMA node, a single node with all cpus if unknown
+std::vector<std::vector<size_t>> numa_nodes();
+
+// cpus sharing a physical core with cpu, excluding cpu
+std::vector<size_t> smt_siblings(size_t cpu);
+// cpus sharing the last level cache with cpu, excluding cpu and its siblings
+std::vector<size_t> llc_siblings(size_t cpu);
+// cpus on a NUMA node other than the node of cpu
+std::vector<size_t> remote_node_cpus(size_t cpu);
+// size in bytes of the last level cache of cpu, 0 if unknown
+size_t llc_size(size_t cpu);
+// size in bytes of the L1 data cache of cpu, 0 if unknown
+size_t l1d_size(size_t cpu);
+
+// pin calling thread, threads created afterwards inherit the affinity
+bool pin_current_thread(std::vector<size_t> const &cpus);
+
+// cpus not in busy, highest numbered first, for threads that must stay off
+// the measurement cpus. empty if every cpu is busy
+std::vector<size_t> housekeeping_cpus(std::vector<size_t> const &busy);
+
+// let the calling thread only run when nothing else wants its cpu
+bool lower_current_thread_priority();
+
+// frequency of the counter read by trampoline, cntpct_el0 on aarch64
+uint64_t timer_frequency();
+
+} // namespace ib::platform
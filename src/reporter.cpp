@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fmt/format.h>
+#include <fstream>
+#include <ios>
+#include <memory>
+#include <optional>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "bootstrap.hpp"
+#include "case_registry.hpp"
+#include "estimator.hpp"
+#include "histogram.hpp"
+#include "interference.hpp"
+#include "platform.hpp"
+#include "reporter.hpp"
+#include "statistic.hpp"
+#include "trace.hpp"
+
+namespace ib::rt {
+
+namespace {
+
+// full redraw now and then, other log output may have scrolled the screen
+constexpr size_t FullRedrawInterval = 30U;
+
+// multi line asm labels collapse to one line
+std::string one_line(std::string_view str) {
+  std::string line{};
+  bool pending_separator = false;
+  size_t begin = 0U;
+  while (begin < str.size()) {
+    size_t end = str.find('\n', begin);
+    if (end == std::string_view::npos)
+      end = str.size();
+    std::string_view part = str.substr(begin, end - begin);
+    size_t const first = part.find_first_not_of(" \t");
+    if (first != std::string_view::npos) {
+      part = part.substr(first, part.find_last_not_of(" \t") - first + 1U);
+      if (pending_separator)
+        line += "; ";
+      line += part;
+      pending_separator = true;
+    }
+    begin = end + 1U;
+  }
+  return line;
+}
+
+// one character per bin, log scaled like the former t-digest plot
+std::string sparkline(Histogram const &histogram) {
+  static constexpr std::array<std::string_view, 9> Levels{
+      " ", "▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+  uint64_t const max_count =
+      *std::max_element(histogram.bins().begin(), histogram.bins().end());
+  double_t const scale = std::log1p(static_cast<double_t>(max_count));
+  std::string line{};
+  for (uint64_t count : histogram.bins()) {
+    size_t level = 0U;
+    if (count > 0U)
+      level = 1U + static_cast<size_t>(
+                       std::log1p(static_cast<double_t>(count)) / scale * 7.0);
+    line += Levels[std::min<size_t>(level, Levels.size() - 1U)];
+  }
+  return line;
+}
+
+// one table per template, a row per case and a column per axis
+void render_template_tables(CaseRegistry const &case_registry,
+                            Report const &report,
+                            std::vector<std::string> &lines) {
+  constexpr int ColWidth = 12;
+  for (auto const &[group, uuids] : case_registry.groups()) {
+    bool has_header = false;
+    for (UUID uuid : uuids) {
+      std::optional<CaseInfo> const info = case_registry.get(uuid);
+      auto const it = report.find(uuid);
+      if (!info.has_value() || it == report.end())
+        continue;
+      if (!has_header) {
+        lines.push_back(group + ":");
+        std::string header{};
+        for (auto const &[name, value] : info->params_)
+          header += fmt::format("{:>{}}", name, ColWidth);
+        header += fmt::format("{:>{}}{:>{}}{:>{}}", "mean", ColWidth,
+                              "median", ColWidth, "samples", ColWidth);
+        lines.push_back(std::move(header));
+        has_header = true;
+      }
+      CaseReport const &case_report = it->second;
+      std::string row{};
+      for (auto const &[name, value] : info->params_)
+        row += fmt::format("{:>{}}", value, ColWidth);
+      row += fmt::format("{:>{}.2f}{:>{}.2f}{:>{}}", case_report.stat_.avr(),
+                         ColWidth, case_report.median_, ColWidth,
+                         case_report.stat_.count(), ColWidth);
+      lines.push_back(std::move(row));
+    }
+    if (has_header)
+      lines.emplace_back();
+  }
+}
+
+bool write_file(std::string const &path,
+                std::vector<std::string> const &lines) {
+  std::string const tmp_path = path + ".tmp";
+  {
+    std::ofstream out{tmp_path, std::ios::trunc};
+    for (std::string const &line : lines)
+      out << line << '\n';
+    if (!out) {
+      spdlog::error("[reporter] failed to write {}", tmp_path);
+      return false;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    spdlog::error("[reporter] failed to rename {} to {}", tmp_path, path);
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+std::vector<std::string> Reporter::render(Report const &report) const {
+  std::vector<std::string> lines{"=======STAT========"};
+  for (auto const &[uuid, case_report] : report) {
+    Stat const &stat = case_report.stat_;
+    lines.push_back(fmt::format("statistics<{}> {}", uuid,
+                                one_line(case_registry_.label(uuid))));
+    lines.push_back(fmt::format(
+        " - cpu cycle: mean {:.3f}, median {:.3f}, confidence interval {}, "
+        "n {}",
+        stat.avr(), case_report.median_, stat.confidence_interval(),
+        stat.count()));
+    UnitStat const &unit_stat = case_report.unit_stat_;
+    lines.push_back(fmt::format(" - average ns: {:.3f}, average timer ticks: "
+                                "{:.3f}",
+                                unit_stat.nanoseconds_.avr(),
+                                unit_stat.ticks_.avr()));
+    Histogram const &histogram = case_report.histogram_;
+    if (histogram.seeded())
+      lines.push_back(fmt::format(" - {} < [{:.2f} |{}| {:.2f}) < {}",
+                                  histogram.underflow(),
+                                  histogram.lower_bound(), sparkline(histogram),
+                                  histogram.upper_bound(),
+                                  histogram.overflow()));
+    std::optional<BootstrapResult> const bootstrap_result =
+        bootstrap_worker_.get(uuid);
+    if (bootstrap_result.has_value()) {
+      RobustEstimate const &robust = bootstrap_result->robust_;
+      lines.push_back(fmt::format(
+          " - median: {:.3f}, trimmed mean: {:.3f}, MAD: {:.3f}, mode: {:.3f}",
+          robust.median_, robust.trimmed_mean_, robust.mad_, robust.mode_));
+      lines.push_back(fmt::format(" - bootstrap CI of mean: {}, of median: {} "
+                                  "(n={})",
+                                  bootstrap_result->mean_,
+                                  bootstrap_result->median_,
+                                  bootstrap_result->n_));
+    }
+    if (case_report.loaded_stat_.has_value()) {
+      Stat const &loaded_stat = case_report.loaded_stat_.value();
+      lines.push_back(fmt::format(" - under interference: {:.3f} cpu cycle, "
+                                  "slowdown {:.3f}x vs solo",
+                                  loaded_stat.avr(),
+                                  loaded_stat.avr() / stat.avr()));
+    }
+    if (unit_stat.frequency_changed_count_ > 0U)
+      lines.push_back(fmt::format(" - {} samples measured during frequency "
+                                  "change",
+                                  unit_stat.frequency_changed_count_));
+  }
+  lines.emplace_back();
+  render_template_tables(case_registry_, report, lines);
+  return lines;
+}
+
+void Reporter::draw(std::vector<std::string> lines) {
+  std::string out{};
+  if (frame_count_++ % FullRedrawInterval == 0U) {
+    out += "\x1b[2J\x1b[H";
+    for (std::string const &line : lines)
+      out += line + "\x1b[K\n";
+  } else {
+    for (size_t row = 0; row < lines.size(); row++) {
+      if (row < screen_.size() && screen_[row] == lines[row])
+        continue;
+      out += fmt::format("\x1b[{};1H{}\x1b[K", row + 1U, lines[row]);
+    }
+    if (lines.size() < screen_.size())
+      out += fmt::format("\x1b[{};1H\x1b[J", lines.size() + 1U);
+    out += fmt::format("\x1b[{};1H", lines.size() + 1U);
+  }
+  std::fwrite(out.data(), 1U, out.size(), stdout);
+  std::fflush(stdout);
+  screen_ = std::move(lines);
+}
+
+void Reporter::start() {
+  // worker of a campaign, coordinator renders the merged result
+  if (options_.report_socket_.has_value())
+    return;
+  std::vector<size_t> const cpus =
+      platform::housekeeping_cpus(measurement_cpus(options_));
+  if (!cpus.empty())
+    platform::pin_current_thread({cpus.front()});
+  else
+    spdlog::warn("[reporter] every cpu measures, share one with reporter");
+  platform::lower_current_thread_priority();
+
+  while (true) {
+    std::this_thread::sleep_for(std::chrono::seconds{1});
+    std::shared_ptr<Report const> report = report_buffer_.latest();
+    if (report == last_report_)
+      continue;
+    last_report_ = std::move(report);
+    IB_TRACE_SPAN("render");
+    std::vector<std::string> lines = render(*last_report_);
+    if (options_.report_path_.has_value())
+      write_file(options_.report_path_.value(), lines);
+    else
+      draw(std::move(lines));
+  }
+}
+
+} // namespace ib::rt
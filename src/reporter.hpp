@@ -0,0 +1,40 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bootstrap.hpp"
+#include "case_registry.hpp"
+#include "options.hpp"
+#include "statistic.hpp"
+
+namespace ib::rt {
+
+// renders published reports from a low priority thread pinned away from the
+// measurement cpus. the terminal only gets the lines that changed since the
+// previous frame, --report rewrites a file instead.
+class Reporter {
+  ReportBuffer const &report_buffer_;
+  BootstrapWorker const &bootstrap_worker_;
+  Options const &options_;
+  CaseRegistry const &case_registry_;
+
+  std::shared_ptr<Report const> last_report_;
+  std::vector<std::string> screen_;
+  size_t frame_count_ = 0U;
+
+  std::vector<std::string> render(Report const &report) const;
+  void draw(std::vector<std::string> lines);
+
+public:
+  explicit Reporter(ReportBuffer const &report_buffer,
+                    BootstrapWorker const &bootstrap_worker,
+                    Options const &options, CaseRegistry const &case_registry)
+      : report_buffer_(report_buffer), bootstrap_worker_(bootstrap_worker),
+        options_(options), case_registry_(case_registry) {}
+
+  void start();
+};
+
+} // namespace ib::rt
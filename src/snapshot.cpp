@@ -0,0 +1,177 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "snapshot.hpp"
+#include "stat.hpp"
+#include "tdigest.hpp"
+
+namespace ib::rt {
+
+namespace {
+
+constexpr char Magic[4] = {'I', 'B', 'S', 'N'};
+// 2: 64 bit sample count
+constexpr uint32_t Version = 2U;
+
+class Writer {
+  std::string &out_;
+
+public:
+  explicit Writer(std::string &out) : out_(out) {}
+
+  template <class T> void write(T v) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    char buf[sizeof(T)];
+    std::memcpy(buf, &v, sizeof(T));
+    out_.append(buf, sizeof(T));
+  }
+};
+
+class Reader {
+  std::string_view in_;
+
+public:
+  explicit Reader(std::string_view in) : in_(in) {}
+
+  template <class T> bool read(T &v) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (in_.size() < sizeof(T))
+      return false;
+    std::memcpy(&v, in_.data(), sizeof(T));
+    in_.remove_prefix(sizeof(T));
+    return true;
+  }
+
+  bool empty() const { return in_.empty(); }
+};
+
+} // namespace
+
+std::string serialize_snapshot(Snapshot const &snapshot) {
+  std::string out{Magic, sizeof(Magic)};
+  Writer writer{out};
+  writer.write(Version);
+  writer.write(static_cast<uint64_t>(snapshot.size()));
+  for (auto const &[uuid, case_snapshot] : snapshot) {
+    Stat::State const state = case_snapshot.stat_.state();
+    writer.write(static_cast<uint64_t>(uuid));
+    writer.write(state.mean_);
+    writer.write(state.m2_);
+    writer.write(state.n_);
+    writer.write(state.min_);
+    writer.write(state.max_);
+    // keeps frames and files at about compression centroids per case
+    TDigest compact = case_snapshot.tdigest_;
+    compact.compress();
+    std::vector<Centroid> const &centroids = compact.getCentroids();
+    writer.write(static_cast<uint64_t>(centroids.size()));
+    for (Centroid const &c : centroids) {
+      writer.write(c.mean);
+      writer.write(c.weight);
+    }
+  }
+  return out;
+}
+
+std::optional<Snapshot> deserialize_snapshot(std::string_view data) {
+  if (data.size() < sizeof(Magic) ||
+      std::memcmp(data.data(), Magic, sizeof(Magic)) != 0) {
+    spdlog::error("[snapshot] bad magic");
+    return std::nullopt;
+  }
+  Reader reader{data.substr(sizeof(Magic))};
+  uint32_t version = 0U;
+  uint64_t case_count = 0U;
+  if (!reader.read(version) || version != Version) {
+    spdlog::error("[snapshot] unsupported version {}", version);
+    return std::nullopt;
+  }
+  if (!reader.read(case_count))
+    return std::nullopt;
+  Snapshot snapshot{};
+  for (uint64_t i = 0; i < case_count; i++) {
+    uint64_t uuid = 0U;
+    Stat::State state{};
+    uint64_t centroid_count = 0U;
+    if (!reader.read(uuid) || !reader.read(state.mean_) ||
+        !reader.read(state.m2_) || !reader.read(state.n_) ||
+        !reader.read(state.min_) || !reader.read(state.max_) ||
+        !reader.read(centroid_count)) {
+      spdlog::error("[snapshot] truncated case {}", i);
+      return std::nullopt;
+    }
+    CaseSnapshot case_snapshot{.stat_ = Stat{state}, .tdigest_ = TDigest{}};
+    for (uint64_t j = 0; j < centroid_count; j++) {
+      double mean = 0.0;
+      double weight = 0.0;
+      if (!reader.read(mean) || !reader.read(weight)) {
+        spdlog::error("[snapshot] truncated centroids of {}", uuid);
+        return std::nullopt;
+      }
+      case_snapshot.tdigest_.centroids_.emplace_back(mean, weight);
+    }
+    snapshot.emplace(uuid, std::move(case_snapshot));
+  }
+  if (!reader.empty()) {
+    spdlog::error("[snapshot] trailing data");
+    return std::nullopt;
+  }
+  return snapshot;
+}
+
+bool write_snapshot(std::string const &path, Snapshot const &snapshot) {
+  std::string const tmp_path = path + ".tmp";
+  {
+    std::ofstream out{tmp_path, std::ios::binary | std::ios::trunc};
+    std::string const data = serialize_snapshot(snapshot);
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!out) {
+      spdlog::error("[snapshot] failed to write {}", tmp_path);
+      return false;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    spdlog::error("[snapshot] failed to rename {} to {}", tmp_path, path);
+    return false;
+  }
+  return true;
+}
+
+std::optional<Snapshot> read_snapshot(std::string const &path) {
+  std::ifstream in{path, std::ios::binary};
+  if (!in) {
+    spdlog::error("[snapshot] failed to open {}", path);
+    return std::nullopt;
+  }
+  std::string const data{std::istreambuf_iterator<char>{in},
+                         std::istreambuf_iterator<char>{}};
+  return deserialize_snapshot(data);
+}
+
+void merge_snapshot(Snapshot &into, Snapshot const &from) {
+  for (auto const &[uuid, case_snapshot] : from) {
+    CaseSnapshot &target = into[uuid];
+    target.stat_.merge(case_snapshot.stat_);
+    target.tdigest_.merge(case_snapshot.tdigest_);
+  }
+}
+
+void log_snapshot(Snapshot const &snapshot) {
+  for (auto const &[uuid, case_snapshot] : snapshot) {
+    Stat const &stat = case_snapshot.stat_;
+    spdlog::info("statistics<{}>:\n - samples: {}\n - average cpu cycle: {}\n"
+                 " - confidence interval: {}\n - median: {}",
+                 uuid, stat.count(), stat.avr(), stat.confidence_interval(),
+                 case_snapshot.tdigest_.quantile(0.5));
+  }
+}
+
+} // namespace ib::rt
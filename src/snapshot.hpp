@@ -0,0 +1,33 @@
+#pragma once
+
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "stat.hpp"
+#include "tdigest.hpp"
+#include "uuid.hpp"
+
+namespace ib::rt {
+
+struct CaseSnapshot {
+  Stat stat_;
+  TDigest tdigest_;
+};
+
+// accumulated statistics keyed by stable case hash, see UUIDUtils::stable
+using Snapshot = std::map<UUID, CaseSnapshot>;
+
+std::string serialize_snapshot(Snapshot const &snapshot);
+std::optional<Snapshot> deserialize_snapshot(std::string_view data);
+
+// write to a temporary file and rename, a crash never leaves a torn snapshot
+bool write_snapshot(std::string const &path, Snapshot const &snapshot);
+std::optional<Snapshot> read_snapshot(std::string const &path);
+
+void merge_snapshot(Snapshot &into, Snapshot const &from);
+
+void log_snapshot(Snapshot const &snapshot);
+
+} // namespace ib::rt
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "estimator.hpp"
+
+namespace ib::rt {
+
+struct ThreeSigma {
+  double_t lower_bound = 0.0;
+  double_t upper_bound = 0.0;
+};
+
+struct Range {
+  double_t lower_bound = 0.0;
+  double_t upper_bound = 0.0;
+};
+
+class Stat {
+  double_t mean_ = 0U;
+  double_t m2_ = 0U;
+  uint64_t n_ = 0U;
+
+  double_t min_ = std::numeric_limits<double_t>::max();
+  double_t max_ = std::numeric_limits<double_t>::lowest();
+
+public:
+  struct State {
+    double_t mean_;
+    double_t m2_;
+    uint64_t n_;
+    double_t min_;
+    double_t max_;
+  };
+
+  Stat() = default;
+  explicit Stat(State const &state)
+      : mean_(state.mean_), m2_(state.m2_), n_(state.n_), min_(state.min_),
+        max_(state.max_) {}
+
+  State state() const { return {mean_, m2_, n_, min_, max_}; }
+
+  void update(double_t v) {
+    n_ += 1;
+    const double_t delta = v - mean_;
+    mean_ += delta / n_;
+    const double_t delta2 = v - mean_;
+    m2_ += delta * delta2;
+    min_ = std::min(min_, v);
+    max_ = std::max(max_, v);
+  }
+
+  // parallel Welford combination of two partial aggregates
+  void merge(Stat const &other) {
+    if (other.n_ == 0U)
+      return;
+    if (n_ == 0U) {
+      *this = other;
+      return;
+    }
+    const double_t na = static_cast<double_t>(n_);
+    const double_t nb = static_cast<double_t>(other.n_);
+    const double_t n = na + nb;
+    const double_t delta = other.mean_ - mean_;
+    mean_ += delta * nb / n;
+    m2_ += other.m2_ + delta * delta * na * nb / n;
+    n_ += other.n_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+  }
+
+  uint64_t count() const { return n_; }
+
+  double avr() const { return mean_; }
+
+  Range get_min_max() const { return {min_, max_}; }
+
+  ThreeSigma three_sigma() const {
+    if (n_ < 2) {
+      return {std::numeric_limits<double>::quiet_NaN(),
+              std::numeric_limits<double>::quiet_NaN()};
+    }
+    const double stddev = std::sqrt(m2_ / (n_ - 1));
+    const double three_sigma = 3.0 * stddev;
+    return {mean_ - three_sigma, mean_ + three_sigma};
+  }
+
+  ConfidenceInterval confidence_interval() const {
+    if (n_ <= 30) {
+      return {std::numeric_limits<double>::quiet_NaN(),
+              std::numeric_limits<double>::quiet_NaN()};
+    }
+    const double stddev = std::sqrt(m2_ / (n_ - 1));
+    const double margin_of_error = 1.96 * stddev / std::sqrt(n_);
+    return {mean_ - margin_of_error, mean_ + margin_of_error};
+  }
+};
+
+} // namespace ib::rt
@@ -1,25 +1,118 @@
 #pragma once
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <fmt/base.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
 
+#include "bootstrap.hpp"
+#include "histogram.hpp"
 #include "multiple_thread_queue.hpp"
+#include "options.hpp"
+#include "stat.hpp"
+#include "tdigest.hpp"
 #include "uuid.hpp"
 
 namespace ib::rt {
 
 struct Sample {
   UUID uuid_;
+  // core cycles, converted from ticks with calibrated ratio
   double_t cpu_cycle_;
+  // raw timer ticks
+  double_t ticks_;
+  double_t nanoseconds_;
+  // core frequency moved while this sample was measured
+  bool frequency_changed_;
+  // measured while aggressors were running
+  bool loaded_;
 };
 
+struct UnitStat {
+  Stat ticks_;
+  Stat nanoseconds_;
+  uint64_t frequency_changed_count_ = 0U;
+};
+
+// keep the latest raw samples for robust estimators and bootstrap
+class SampleBuffer {
+  static constexpr size_t Capacity = 1U << 16;
+  std::vector<double_t> samples_{};
+  size_t next_ = 0U;
+
+public:
+  void push(double_t v) {
+    if (samples_.size() < Capacity) {
+      samples_.push_back(v);
+      return;
+    }
+    samples_[next_] = v;
+    next_ = (next_ + 1U) % Capacity;
+  }
+
+  std::vector<double_t> const &samples() const { return samples_; }
+};
+
+// summaries only, the digests stay with the aggregator
+struct CaseReport {
+  Stat stat_;
+  double_t median_ = 0.0;
+  Histogram histogram_;
+  UnitStat unit_stat_;
+  std::optional<Stat> loaded_stat_;
+};
+
+using Report = std::map<UUID, CaseReport>;
+
+// aggregator fills a fresh report while readers keep the previous one, so
+// neither side waits for the other longer than a pointer swap
+class ReportBuffer {
+  mutable std::mutex mutex_;
+  std::shared_ptr<Report const> front_ = std::make_shared<Report const>();
+
+public:
+  void publish(Report report) {
+    std::shared_ptr<Report const> next =
+        std::make_shared<Report const>(std::move(report));
+    std::lock_guard<std::mutex> lock(mutex_);
+    front_.swap(next);
+  }
+
+  std::shared_ptr<Report const> latest() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return front_;
+  }
+};
+
+// aggregates samples, rendering is left to Reporter on another cpu
 class Statistic {
   MultipleThreadQueue<Sample> &statistic_queue_;
+  BootstrapWorker &bootstrap_worker_;
+  ReportBuffer &report_buffer_;
+  Options const &options_;
+
+  std::map<UUID, Stat> stats_;
+  std::map<UUID, TDigest> tdigests_;
+  std::map<UUID, Histogram> histograms_;
+  std::map<UUID, SampleBuffer> sample_buffers_;
+  std::map<UUID, UnitStat> unit_stats_;
+  std::map<UUID, Stat> loaded_stats_;
+
+  Report collect_report() const;
 
 public:
-  explicit Statistic(MultipleThreadQueue<Sample> &statistic_queue)
-      : statistic_queue_(statistic_queue) {}
+  explicit Statistic(MultipleThreadQueue<Sample> &statistic_queue,
+                     BootstrapWorker &bootstrap_worker,
+                     ReportBuffer &report_buffer, Options const &options)
+      : statistic_queue_(statistic_queue), bootstrap_worker_(bootstrap_worker),
+        report_buffer_(report_buffer), options_(options) {}
 
+  void update(Sample const &sample);
   void start();
 };
 
@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <vector>
+
+#include "asm_template.hpp"
+#include "campaign.hpp"
+#include "case_registry.hpp"
+#include "llvm.hpp"
+#include "machine_code.hpp"
+#include "suite.hpp"
+#include "uuid.hpp"
+
+namespace ib {
+
+std::optional<UUID> Suite::add_target(UUID uuid, std::string const &asm_str,
+                                      CaseInfo info) {
+  if (!in_shard(options_, uuid))
+    return uuid;
+  // assemble outside of lock, callers compile in parallel
+  std::unique_ptr<MachineCode> machine_code =
+      ib::llvm::compile_snippet(asm_str);
+  if (machine_code == nullptr) {
+    spdlog::error("failed to compile \"{}\"", asm_str);
+    return std::nullopt;
+  }
+  machine_code->uuid_ = uuid;
+  spdlog::info("machine code for \"{}\":\n{}", asm_str, *machine_code);
+  if (uuid != UUIDUtils::control_group_uuid) {
+    std::string const encoding{machine_code->begin(), machine_code->end()};
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto const [it, inserted] = encodings_.emplace(encoding, uuid);
+    if (!inserted) {
+      spdlog::info("same encoding as uuid {}, skip", it->second);
+      return it->second;
+    }
+  }
+  info.asm_ = asm_str;
+  case_registry_.add(uuid, std::move(info));
+  machine_code_queue_.push(std::move(machine_code));
+  return uuid;
+}
+
+std::optional<UUID> Suite::add_target(std::string const &asm_str) {
+  return add_target(UUIDUtils::stable(asm_str), asm_str);
+}
+
+std::optional<TemplateResult>
+Suite::add_template(std::string const &name, std::string const &source) {
+  std::optional<AsmTemplate> const asm_template = AsmTemplate::parse(source);
+  if (!asm_template.has_value())
+    return std::nullopt;
+  spdlog::info("template {} expands to {} cases", name,
+               asm_template->case_count());
+  TemplateResult result{};
+  for (TemplateCase const &template_case : asm_template->expand()) {
+    std::optional<UUID> const uuid = add_target(
+        UUIDUtils::stable(template_case.asm_), template_case.asm_,
+        CaseInfo{.group_ = name, .params_ = template_case.params_, .asm_ = {}});
+    if (uuid.has_value()) {
+      result.uuids_.push_back(uuid.value());
+      continue;
+    }
+    std::string params{};
+    for (auto const &[axis, value] : template_case.params_)
+      params += (params.empty() ? "" : ", ") + axis + "=" + value;
+    spdlog::warn("template {} skips variant {}", name, params);
+    result.failed_.push_back(std::move(params));
+  }
+  return result;
+}
+
+bool Suite::cancel(UUID uuid) {
+  if (uuid == UUIDUtils::control_group_uuid)
+    return false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto const it = std::find_if(
+        encodings_.begin(), encodings_.end(),
+        [uuid](auto const &encoding) { return encoding.second == uuid; });
+    if (it == encodings_.end())
+      return false;
+    // same code may be added again later
+    encodings_.erase(it);
+  }
+  case_registry_.remove(uuid);
+  cancel_queue_.push(std::make_unique<UUID>(uuid));
+  return true;
+}
+
+} // namespace ib
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "case_registry.hpp"
+#include "machine_code.hpp"
+#include "multiple_thread_queue.hpp"
+#include "options.hpp"
+#include "uuid.hpp"
+
+namespace ib {
+
+struct TemplateResult {
+  std::vector<UUID> uuids_;
+  // parameters of variants which did not assemble, e.g. "n=3, r=x1"
+  std::vector<std::string> failed_;
+};
+
+// compile cases and hand them to executor, safe to call from several threads
+class Suite {
+  MultipleThreadQueue<MachineCode> &machine_code_queue_;
+  MultipleThreadQueue<UUID> &cancel_queue_;
+  Options const &options_;
+  CaseRegistry &case_registry_;
+  std::mutex mutex_;
+  // encoding => uuid, identical machine code is measured once
+  std::map<std::string, UUID> encodings_;
+
+public:
+  explicit Suite(MultipleThreadQueue<MachineCode> &machine_code_queue,
+                 MultipleThreadQueue<UUID> &cancel_queue,
+                 Options const &options, CaseRegistry &case_registry)
+      : machine_code_queue_(machine_code_queue), cancel_queue_(cancel_queue),
+        options_(options), case_registry_(case_registry) {}
+
+  // returns uuid the case is measured under, nullopt if it does not assemble
+  std::optional<UUID> add_target(UUID uuid, std::string const &asm_str,
+                                 CaseInfo info = CaseInfo{});
+  std::optional<UUID> add_target(std::string const &asm_str);
+
+  // expand template into cases grouped under name. variants which do not
+  // assemble are skipped, nullopt only if the template does not parse
+  std::optional<TemplateResult> add_template(std::string const &name,
+                                             std::string const &source);
+
+  // stop measuring, returns false for unknown uuid
+  bool cancel(UUID uuid);
+};
+
+} // namespace ib
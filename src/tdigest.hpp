@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <utility>
+#include <vector>
+
+namespace ib::rt {
+
+struct Centroid {
+  double mean;
+  double weight; // Number of data points in this centroid
+
+  Centroid(double m, double w) : mean(m), weight(w) {}
+};
+
+struct TDigest {
+  std::vector<Centroid> centroids_;
+  // roughly the number of centroids kept after compress()
+  double compression_;
+
+  explicit TDigest(double compression = 500.0) : compression_(compression) {}
+
+  void add(double value) { add(value, 1.0); }
+
+  // centroids stay sorted, the neighbours of the insert position are the
+  // only candidates for an equal mean
+  void add(double value, double weight) {
+    auto insertPos = std::upper_bound(
+        centroids_.begin(), centroids_.end(), value,
+        [](double val, const Centroid &c) { return val < c.mean; });
+    if (insertPos != centroids_.begin() &&
+        std::abs((insertPos - 1)->mean - value) < 1e-9) {
+      (insertPos - 1)->weight += weight;
+      return;
+    }
+    centroids_.insert(insertPos, Centroid(value, weight));
+    compressIfNecessary();
+  }
+
+  // continuous samples would otherwise keep one centroid each
+  void compressIfNecessary() {
+    if (centroids_.size() > 2U * static_cast<size_t>(compression_))
+      compress();
+  }
+
+  // merge neighbours while a centroid spans at most one unit of the t-digest
+  // scale k(q) = compression / (2 pi) * asin(2q - 1). units are narrow near
+  // the tails, so extreme quantiles keep their resolution, and the digest
+  // ends up with about compression centroids
+  void compress() {
+    double totalWeight = 0.0;
+    for (const auto &c : centroids_)
+      totalWeight += c.weight;
+    auto k = [this, totalWeight](double weight) {
+      double q = std::clamp(weight / totalWeight, 0.0, 1.0);
+      return compression_ / (2.0 * std::numbers::pi) * std::asin(2.0 * q - 1.0);
+    };
+    std::vector<Centroid> newCentroids;
+    double weightSoFar = 0.0;
+    for (const auto &c : centroids_) {
+      if (!newCentroids.empty()) {
+        Centroid &last = newCentroids.back();
+        double combinedWeight = last.weight + c.weight;
+        if (k(weightSoFar + combinedWeight) - k(weightSoFar) <= 1.0) {
+          last.mean =
+              (last.mean * last.weight + c.mean * c.weight) / combinedWeight;
+          last.weight = combinedWeight;
+          continue;
+        }
+        weightSoFar += last.weight;
+      }
+      newCentroids.push_back(c);
+    }
+    centroids_ = std::move(newCentroids);
+  }
+
+  double getRatio(double v) const {
+    if (centroids_.empty())
+      return 0.0;
+    double totalWeight = 0.0;
+    double lessThanVWeight = 0.0;
+    for (const auto &c : centroids_) {
+      totalWeight += c.weight;
+      if (c.mean < v)
+        lessThanVWeight += c.weight;
+    }
+    return lessThanVWeight / totalWeight;
+  }
+
+  // Estimate the quantile (0.0 <= q <= 1.0)
+  double quantile(double q) const {
+    if (centroids_.empty())
+      return std::numeric_limits<double>::quiet_NaN();
+    if (q <= 0.0)
+      return centroids_[0].mean;
+    if (q >= 1.0)
+      return centroids_.back().mean;
+
+    // Compute cumulative weights, a centroid's mean sits at its center
+    std::vector<std::pair<double, double>> cumulative;
+    double totalWeight = 0.0;
+    for (const auto &c : centroids_) {
+      cumulative.emplace_back(totalWeight + c.weight / 2.0, c.mean);
+      totalWeight += c.weight;
+    }
+
+    // Find the segment containing the quantile
+    double targetWeight = q * totalWeight;
+    auto it = std::upper_bound(
+        cumulative.begin(), cumulative.end(), std::make_pair(targetWeight, 0.0),
+        [](const std::pair<double, double> &a,
+           const std::pair<double, double> &b) { return a.first < b.first; });
+
+    if (it == cumulative.begin())
+      return centroids_[0].mean;
+    if (it == cumulative.end())
+      return centroids_.back().mean;
+
+    auto left = it - 1;
+    auto right = it;
+    double leftWeight = left->first;
+    double rightWeight = right->first;
+    double leftMean = left->second;
+    double rightMean = right->second;
+
+    // Linear interpolation
+    double fraction = (targetWeight - leftWeight) / (rightWeight - leftWeight);
+    return leftMean + fraction * (rightMean - leftMean);
+  }
+
+  // both centroid lists are sorted by mean, merge them in one linear pass
+  void merge(TDigest const &other) {
+    std::vector<Centroid> merged{};
+    merged.reserve(centroids_.size() + other.centroids_.size());
+    auto const push = [&merged](Centroid const &c) {
+      if (!merged.empty() && std::abs(merged.back().mean - c.mean) < 1e-9)
+        merged.back().weight += c.weight;
+      else
+        merged.push_back(c);
+    };
+    auto a = centroids_.begin();
+    auto b = other.centroids_.begin();
+    while (a != centroids_.end() || b != other.centroids_.end()) {
+      if (b == other.centroids_.end() ||
+          (a != centroids_.end() && a->mean <= b->mean))
+        push(*a++);
+      else
+        push(*b++);
+    }
+    centroids_ = std::move(merged);
+    compress();
+  }
+
+  // Get all centroids (for debugging/testing)
+  const std::vector<Centroid> &getCentroids() const { return centroids_; }
+};
+
+} // namespace ib::rt
@@ -0,0 +1,211 @@
+#include <string>
+
+#include "trace.hpp"
+
+#if defined(IB_ENABLE_TRACE)
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+#include <vector>
+
+namespace ib::trace {
+
+namespace {
+
+// single writer ring, readers copy slots and drop the ones overwritten while
+// copying. slots are relaxed atomics so readers never race with the writer.
+// a buffer outlives its thread and is handed to the next new thread, so
+// short lived threads do not grow the registry. every owner gets a fresh tid
+// and each event keeps the tid it was recorded under.
+class ThreadBuffer {
+  static constexpr size_t Capacity = 1U << 16;
+
+  struct Slot {
+    std::atomic<uint64_t> name_;
+    std::atomic<uint32_t> tid_;
+    std::atomic<uint64_t> begin_ns_;
+    std::atomic<uint64_t> duration_ns_;
+  };
+
+  std::unique_ptr<Slot[]> slots_{new Slot[Capacity]};
+  std::atomic<uint64_t> head_{0U};
+
+public:
+  // tid of the current owner, only touched by that thread
+  uint32_t tid_;
+  // owned by a live thread, only cleared outside registry_mutex
+  std::atomic<bool> in_use_{true};
+
+  explicit ThreadBuffer(uint32_t tid) : tid_(tid) {}
+
+  void record(char const *name, uint64_t begin_ns, uint64_t end_ns) {
+    uint64_t const head = head_.load(std::memory_order_relaxed);
+    Slot &slot = slots_[head % Capacity];
+    slot.name_.store(reinterpret_cast<uint64_t>(name),
+                     std::memory_order_relaxed);
+    slot.tid_.store(tid_, std::memory_order_relaxed);
+    slot.begin_ns_.store(begin_ns, std::memory_order_relaxed);
+    slot.duration_ns_.store(end_ns - begin_ns, std::memory_order_relaxed);
+    head_.store(head + 1U, std::memory_order_release);
+  }
+
+  struct Event {
+    char const *name_;
+    uint32_t tid_;
+    uint64_t begin_ns_;
+    uint64_t duration_ns_;
+  };
+
+  std::vector<Event> copy() const {
+    uint64_t const head = head_.load(std::memory_order_acquire);
+    uint64_t const begin = head > Capacity ? head - Capacity : 0U;
+    std::vector<Event> events{};
+    events.reserve(head - begin);
+    for (uint64_t i = begin; i < head; i++) {
+      Slot const &slot = slots_[i % Capacity];
+      events.push_back(
+          {.name_ = reinterpret_cast<char const *>(
+               slot.name_.load(std::memory_order_relaxed)),
+           .tid_ = slot.tid_.load(std::memory_order_relaxed),
+           .begin_ns_ = slot.begin_ns_.load(std::memory_order_relaxed),
+           .duration_ns_ = slot.duration_ns_.load(std::memory_order_relaxed)});
+    }
+    // writer may have lapped the oldest slots while copying
+    uint64_t const new_head = head_.load(std::memory_order_acquire);
+    size_t const overwritten =
+        new_head - begin > Capacity ? new_head - begin - Capacity : 0U;
+    events.erase(events.begin(),
+                 events.begin() + std::min(overwritten, events.size()));
+    return events;
+  }
+};
+
+std::mutex registry_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>> registry;
+// names outlive their threads, events of an exited thread keep its name
+std::map<uint32_t, char const *> thread_names;
+uint32_t next_tid = 0U;
+
+ThreadBuffer *acquire_buffer() {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  uint32_t const tid = next_tid++;
+  for (auto const &buffer : registry) {
+    if (!buffer->in_use_.load(std::memory_order_acquire)) {
+      buffer->in_use_.store(true, std::memory_order_relaxed);
+      buffer->tid_ = tid;
+      return buffer.get();
+    }
+  }
+  registry.push_back(std::make_unique<ThreadBuffer>(tid));
+  return registry.back().get();
+}
+
+// returns the buffer to the registry when its thread exits
+class BufferLease {
+  ThreadBuffer *buffer_ = nullptr;
+
+public:
+  BufferLease() = default;
+  ~BufferLease() {
+    if (buffer_ != nullptr)
+      buffer_->in_use_.store(false, std::memory_order_release);
+  }
+  BufferLease(BufferLease const &) = delete;
+  BufferLease &operator=(BufferLease const &) = delete;
+
+  ThreadBuffer &get() {
+    if (buffer_ == nullptr)
+      buffer_ = acquire_buffer();
+    return *buffer_;
+  }
+};
+
+ThreadBuffer &thread_buffer() {
+  thread_local BufferLease lease{};
+  return lease.get();
+}
+
+} // namespace
+
+uint64_t now_ns() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+void record(char const *name, uint64_t begin_ns) {
+  thread_buffer().record(name, begin_ns, now_ns());
+}
+
+void set_thread_name(char const *name) {
+  uint32_t const tid = thread_buffer().tid_;
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  thread_names[tid] = name;
+}
+
+bool dump(std::string const &path) {
+  std::vector<ThreadBuffer const *> buffers{};
+  std::map<uint32_t, char const *> names{};
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (auto const &buffer : registry)
+      buffers.push_back(buffer.get());
+    names = thread_names;
+  }
+  std::string const tmp_path = path + ".tmp";
+  std::ofstream out{tmp_path, std::ios::trunc};
+  int const pid = static_cast<int>(getpid());
+  out << "{\"traceEvents\":[\n";
+  bool first = true;
+  auto const separator = [&]() -> char const * {
+    char const *const sep = first ? "" : ",\n";
+    first = false;
+    return sep;
+  };
+  for (auto const &[tid, name] : names)
+    out << separator()
+        << fmt::format("{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":{},"
+                       "\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}",
+                       pid, tid, name);
+  for (ThreadBuffer const *buffer : buffers) {
+    for (auto const &event : buffer->copy()) {
+      out << separator()
+          << fmt::format("{{\"name\":\"{}\",\"ph\":\"X\",\"ts\":{:.3f},"
+                         "\"dur\":{:.3f},\"pid\":{},\"tid\":{}}}",
+                         event.name_,
+                         static_cast<double>(event.begin_ns_) / 1e3,
+                         static_cast<double>(event.duration_ns_) / 1e3, pid,
+                         event.tid_);
+    }
+  }
+  out << "\n]}\n";
+  out.close();
+  if (!out || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    spdlog::error("[trace] failed to write {}", path);
+    return false;
+  }
+  return true;
+}
+
+} // namespace ib::trace
+
+#else
+
+namespace ib::trace {
+
+bool dump(std::string const &) { return false; }
+
+} // namespace ib::trace
+
+#endif
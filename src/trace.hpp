@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// span tracing, compiled out unless configured with -DINSTR_BENCH_TRACE=ON.
+//   IB_TRACE_SPAN("measure");  // begin here, one event at scope exit
+
+namespace ib::trace {
+
+#if defined(IB_ENABLE_TRACE)
+
+inline constexpr bool enabled = true;
+
+uint64_t now_ns();
+// complete event from begin_ns until now
+void record(char const *name, uint64_t begin_ns);
+void set_thread_name(char const *name);
+
+class Span {
+  char const *name_;
+  uint64_t begin_ns_;
+
+public:
+  explicit Span(char const *name) : name_(name), begin_ns_(now_ns()) {}
+  ~Span() { record(name_, begin_ns_); }
+  Span(Span const &) = delete;
+  Span &operator=(Span const &) = delete;
+};
+
+#define IB_TRACE_CONCAT_IMPL(a, b) a##b
+#define IB_TRACE_CONCAT(a, b) IB_TRACE_CONCAT_IMPL(a, b)
+#define IB_TRACE_SPAN(name)                                                    \
+  ::ib::trace::Span IB_TRACE_CONCAT(ib_trace_span_, __LINE__) { name }
+
+#else
+
+inline constexpr bool enabled = false;
+
+inline void set_thread_name(char const *) {}
+
+#define IB_TRACE_SPAN(name) static_cast<void>(0)
+
+#endif
+
+// write buffered events as chrome trace json, false when disabled or failed
+bool dump(std::string const &path);
+
+} // namespace ib::trace
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+
+#include "initial_state.hpp"
+
+// load state, run machine code repeat_count times, store elapsed timer ticks
+// to result. fpcr and callee saved registers are restored afterwards
+extern "C" void trampoline(int64_t *result, void *machine_code_address,
+                           uint64_t repeat_count,
+                           ib::rt::InitialState *initial_state);
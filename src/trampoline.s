@@ -4,9 +4,16 @@ _trampoline:
   ;; x0 result ptr
   ;; x1 target address
   ;; x2 repeat count
-  stp     x29, x30, [sp, #-64]!
+  ;; x3 initial state, layout in initial_state.hpp
+  stp     x29, x30, [sp, #-128]!
   stp     x19, x20, [sp, #16]
   stp     x21, x22, [sp, #32]
+  stp     x23, x24, [sp, #48]
+  ;; low halves of v8-v15 are callee saved
+  stp     d8, d9, [sp, #64]
+  stp     d10, d11, [sp, #80]
+  stp     d12, d13, [sp, #96]
+  stp     d14, d15, [sp, #112]
   mov     x29, sp
 
   ;; mov to non-volatile reg since we use it after bench
@@ -14,10 +21,54 @@ _trampoline:
   mov     x20, x1
   ;; x21 counter
   mov     x21, x2
+  ;; x23 flags, set again before every call
+  ldr     x23, [x3, #648]
+  ;; x24 caller fpcr, restored after bench
+  mrs     x24, fpcr
+  ldr     x9, [x3, #640]
+  msr     fpcr, x9
+
+  ;; v0-v31
+  add     x9, x3, #128
+  ldp     q0, q1, [x9], #32
+  ldp     q2, q3, [x9], #32
+  ldp     q4, q5, [x9], #32
+  ldp     q6, q7, [x9], #32
+  ldp     q8, q9, [x9], #32
+  ldp     q10, q11, [x9], #32
+  ldp     q12, q13, [x9], #32
+  ldp     q14, q15, [x9], #32
+  ldp     q16, q17, [x9], #32
+  ldp     q18, q19, [x9], #32
+  ldp     q20, q21, [x9], #32
+  ldp     q22, q23, [x9], #32
+  ldp     q24, q25, [x9], #32
+  ldp     q26, q27, [x9], #32
+  ldp     q28, q29, [x9], #32
+  ldp     q30, q31, [x9], #32
+
+  ;; x0-x15, x3 last since it holds the state address
+  ldp     x1, x2, [x3, #8]
+  ldp     x4, x5, [x3, #32]
+  ldp     x6, x7, [x3, #48]
+  ldp     x8, x9, [x3, #64]
+  ldp     x10, x11, [x3, #80]
+  ldp     x12, x13, [x3, #96]
+  ldp     x14, x15, [x3, #112]
+  ldr     x0, [x3, #656]
+  cbz     x0, .gpr_x0
+  add     x0, x3, #704 ;; x0 = scratch
+  b       .gpr_x3
+.gpr_x0:
+  ldr     x0, [x3]
+.gpr_x3:
+  ldr     x3, [x3, #24]
+
   ;; x22 start time
   mrs     x22, cntpct_el0
 
 .loop:
+  msr     nzcv, x23
   isb
   blr     x20
   isb
@@ -27,8 +78,14 @@ _trampoline:
   mrs     x0, cntpct_el0
   sub     x0, x0, x22 ;; x0 = end - start
   str     x0, [x19]
-  
+  msr     fpcr, x24
+
+  ldp     d8, d9, [sp, #64]
+  ldp     d10, d11, [sp, #80]
+  ldp     d12, d13, [sp, #96]
+  ldp     d14, d15, [sp, #112]
   ldp     x19, x20, [sp, #16]
   ldp     x21, x22, [sp, #32]
-  ldp     x29, x30, [sp], #64
+  ldp     x23, x24, [sp, #48]
+  ldp     x29, x30, [sp], #128
   ret
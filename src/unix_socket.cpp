@@ -0,0 +1,109 @@
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "unix_socket.hpp"
+
+namespace ib {
+
+static std::optional<sockaddr_un> make_address(std::string const &path) {
+  sockaddr_un address{};
+  if (path.size() >= sizeof(address.sun_path)) {
+    spdlog::error("[socket] path too long: {}", path);
+    return std::nullopt;
+  }
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  return address;
+}
+
+int listen_unix_socket(std::string const &path) {
+  std::optional<sockaddr_un> const address = make_address(path);
+  if (!address.has_value())
+    return -1;
+  int const fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    spdlog::error("[socket] socket failed: {}", std::strerror(errno));
+    return -1;
+  }
+  unlink(path.c_str());
+  if (bind(fd, reinterpret_cast<sockaddr const *>(&address.value()),
+           sizeof(sockaddr_un)) != 0 ||
+      listen(fd, SOMAXCONN) != 0) {
+    spdlog::error("[socket] failed to listen on {}: {}", path,
+                  std::strerror(errno));
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int connect_unix_socket(std::string const &path) {
+  std::optional<sockaddr_un> const address = make_address(path);
+  if (!address.has_value())
+    return -1;
+  int const fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    spdlog::error("[socket] socket failed: {}", std::strerror(errno));
+    return -1;
+  }
+  if (connect(fd, reinterpret_cast<sockaddr const *>(&address.value()),
+              sizeof(sockaddr_un)) != 0) {
+    spdlog::error("[socket] failed to connect to {}: {}", path,
+                  std::strerror(errno));
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static bool write_all(int fd, char const *data, size_t size) {
+  while (size > 0) {
+    ssize_t const written = write(fd, data, size);
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written <= 0)
+      return false;
+    data += written;
+    size -= static_cast<size_t>(written);
+  }
+  return true;
+}
+
+static bool read_all(int fd, char *data, size_t size) {
+  while (size > 0) {
+    ssize_t const count = read(fd, data, size);
+    if (count < 0 && errno == EINTR)
+      continue;
+    if (count <= 0)
+      return false;
+    data += count;
+    size -= static_cast<size_t>(count);
+  }
+  return true;
+}
+
+bool send_frame(int fd, std::string_view payload) {
+  uint32_t const size = static_cast<uint32_t>(payload.size());
+  return write_all(fd, reinterpret_cast<char const *>(&size), sizeof(size)) &&
+         write_all(fd, payload.data(), payload.size());
+}
+
+std::optional<std::string> recv_frame(int fd) {
+  uint32_t size = 0U;
+  if (!read_all(fd, reinterpret_cast<char *>(&size), sizeof(size)))
+    return std::nullopt;
+  std::string payload(size, '\0');
+  if (!read_all(fd, payload.data(), size))
+    return std::nullopt;
+  return payload;
+}
+
+} // namespace ib
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace ib {
+
+// length prefixed frames over a unix domain stream socket. the payload is
+// opaque so the same framing works over tcp when workers leave the host.
+int listen_unix_socket(std::string const &path);
+int connect_unix_socket(std::string const &path);
+
+bool send_frame(int fd, std::string_view payload);
+std::optional<std::string> recv_frame(int fd);
+
+} // namespace ib
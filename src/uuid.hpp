@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <string_view>
 
 namespace ib {
 
@@ -13,6 +14,17 @@ inline UUID alloc() {
   return id++;
 }
 inline constexpr UUID control_group_uuid = static_cast<UUID>(-1);
+inline constexpr UUID calibration_uuid = static_cast<UUID>(-2);
+
+// FNV-1a of the case source, identical across processes and runs
+constexpr UUID stable(std::string_view source) {
+  UUID hash = 0xCBF29CE484222325ULL;
+  for (char c : source) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001B3ULL;
+  }
+  return hash >= calibration_uuid ? hash - 2U : hash;
+}
 
 } // namespace UUIDUtils
 